@@ -1,6 +1,38 @@
 ﻿#include <iostream>
 #include <string>
 #include <ctime>
+#include <cstdint>
+#include <stdexcept>
+
+// Счетчиковый генератор (SplitMix64): значение зависит только от
+// (seed, номер боя, номер хода), поэтому любой бой можно воспроизвести
+// по seed, а параллельные бои не делят общее скрытое состояние.
+class BattleRandom {
+private:
+    uint64_t seed;
+    uint64_t battleId;
+    uint32_t turn = 0;
+
+    static uint64_t mix(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+public:
+    BattleRandom(uint64_t s, uint64_t battle) : seed(s), battleId(battle) {}
+
+    static uint64_t at(uint64_t seed, uint64_t battle, uint32_t turn) {
+        return mix(mix(seed ^ mix(battle)) ^ turn);
+    }
+
+    // Число от 0 до 99 для очередного хода боя.
+    int rollPercent() {
+        uint64_t bits = at(seed, battleId, turn++);
+        return static_cast<int>(((bits >> 32) * 100) >> 32);
+    }
+};
 
 class Entity {
 protected:
@@ -21,7 +53,7 @@ public:
 
     void reduceHealth(int amount) { health -= amount; }
 
-    virtual void attack(Entity& target) = 0;
+    virtual void attack(Entity& target, BattleRandom& random) = 0;
 
     virtual void heal(int amount) {
         std::cout << name << " cannot heal!\n";
@@ -38,10 +70,10 @@ public:
     Character(const std::string& n, int h, int a, int d)
         : Entity(n, h, a, d) {}
 
-    void attack(Entity& target) override {
+    void attack(Entity& target, BattleRandom& random) override {
         int damage = attackPower - target.getDefense();
         if (damage > 0) {
-            if (rand() % 100 < 20) { // Критический удар (20%)
+            if (random.rollPercent() < 20) { // Критический удар (20%)
                 damage *= 2;
                 std::cout << "Critical hit! ";
             }
@@ -72,10 +104,10 @@ public:
     Monster(const std::string& n, int h, int a, int d)
         : Entity(n, h, a, d) {}
 
-    void attack(Entity& target) override {
+    void attack(Entity& target, BattleRandom& random) override {
         int damage = attackPower - target.getDefense();
         if (damage > 0) {
-            if (rand() % 100 < 30) { // Ядовитая атака (30%)
+            if (random.rollPercent() < 30) { // Ядовитая атака (30%)
                 damage += 5;
                 std::cout << "Poisonous attack! ";
             }
@@ -99,10 +131,10 @@ public:
     Boss(const std::string& n, int h, int a, int d)
         : Monster(n, h, a, d) {}
 
-    void attack(Entity& target) override {
+    void attack(Entity& target, BattleRandom& random) override {
         int damage = attackPower - target.getDefense();
         if (damage > 0) {
-            if (rand() % 100 < 40) { // Огненный удар (40% вероятность)
+            if (random.rollPercent() < 40) { // Огненный удар (40% вероятность)
                 damage += 10;
                 std::cout << "Fire Strike! ";
             }
@@ -121,8 +153,19 @@ public:
     }
 };
 
-int main() {
-    srand(static_cast<unsigned>(time(0)));
+int main(int argc, char* argv[]) {
+    // Seed можно передать аргументом, чтобы повторить тот же бой
+    uint64_t seed = static_cast<uint64_t>(time(0));
+    if (argc > 1) {
+        try {
+            seed = std::stoull(argv[1]);
+        } catch (const std::exception&) {
+            std::cerr << "Usage: " << argv[0] << " [seed]" << std::endl;
+            return 1;
+        }
+    }
+    BattleRandom battle(seed, 0);
+    std::cout << "Battle seed: " << seed << std::endl;
 
     Character hero("Hero", 100, 20, 10);
     Monster goblin("Goblin", 50, 15, 5);
@@ -136,9 +179,9 @@ int main() {
     }
 
     // Бой
-    hero.attack(goblin);
-    goblin.attack(hero);
-    dragon.attack(hero);
+    hero.attack(goblin, battle);
+    goblin.attack(hero, battle);
+    dragon.attack(hero, battle);
 
     // Лечение персонажа
     std::cout << "\nHero decides to heal...\n";
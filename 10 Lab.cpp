@@ -1,3 +1,9 @@
+// Нужен C++20 (<bit>: bit_width, popcount):
+// g++ -std=c++20 -pthread, MSVC /std:c++20.
+#if !(__cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L))
+#error "Требуется C++20: соберите с -std=c++20"
+#endif
+
 #include <iostream>
 #include <string>
 #include <vector>
@@ -6,7 +12,34 @@
 #include <algorithm>
 #include <stdexcept>
 #include <typeinfo>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <ctime>
+#include <unordered_map>
+#include <map>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <thread>
+#include <cwctype>
 #include <locale.h> 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 class AccessViolationError : public runtime_error {
@@ -19,9 +52,85 @@ public:
     DataValidationError(const string& msg) : runtime_error(msg) {}
 };
 
+// Приведение UTF-8 к нижнему регистру для ASCII и двухбайтовой кириллицы
+// (А-Я, Ё и Ѐ-Џ). Длина строки не меняется: каждая пара D0 xx переходит
+// в D0 или D1 с новым вторым байтом. Решение для байта зависит от соседних
+// байтов исходной строки, поэтому блок SSE2 читает её со сдвигом на -1 и +1.
+inline unsigned char foldUtf8Byte(unsigned char previous, unsigned char current, unsigned char next) {
+    if (current >= 'A' && current <= 'Z') return current + 0x20;
+    if (current == 0xD0 && next >= 0x80 && next <= 0xAF && !(next >= 0x90 && next <= 0x9F)) return 0xD1;
+    if (previous == 0xD0) {
+        if (current >= 0x90 && current <= 0x9F) return current + 0x20;
+        if (current >= 0xA0 && current <= 0xAF) return current - 0x20;
+        if (current >= 0x80 && current <= 0x8F) return current + 0x10;
+    }
+    return current;
+}
+
+#ifdef __SSE2__
+inline __m128i bytesInRange(__m128i bytes, unsigned char low, unsigned char high) {
+    __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(static_cast<char>(low)));
+    return _mm_cmpeq_epi8(_mm_subs_epu8(shifted, _mm_set1_epi8(static_cast<char>(high - low))), _mm_setzero_si128());
+}
+
+inline __m128i foldUtf8Block(__m128i previous, __m128i current, __m128i next) {
+    __m128i lead = _mm_set1_epi8(static_cast<char>(0xD0));
+    __m128i afterLead = _mm_cmpeq_epi8(previous, lead);
+
+    __m128i upperAscii = bytesInRange(current, 'A', 'Z');
+    __m128i firstHalf = _mm_and_si128(afterLead, bytesInRange(current, 0x90, 0x9F));
+    __m128i secondHalf = _mm_and_si128(afterLead, bytesInRange(current, 0xA0, 0xAF));
+    __m128i extended = _mm_and_si128(afterLead, bytesInRange(current, 0x80, 0x8F));
+    __m128i movesLead = _mm_and_si128(_mm_cmpeq_epi8(current, lead),
+        _mm_andnot_si128(bytesInRange(next, 0x90, 0x9F), bytesInRange(next, 0x80, 0xAF)));
+
+    __m128i adjust = _mm_and_si128(_mm_or_si128(upperAscii, firstHalf), _mm_set1_epi8(0x20));
+    adjust = _mm_or_si128(adjust, _mm_and_si128(secondHalf, _mm_set1_epi8(static_cast<char>(-0x20))));
+    adjust = _mm_or_si128(adjust, _mm_and_si128(extended, _mm_set1_epi8(0x10)));
+    adjust = _mm_or_si128(adjust, _mm_and_si128(movesLead, _mm_set1_epi8(1)));
+    return _mm_add_epi8(current, adjust);
+}
+#endif
+
+inline string foldCaseUtf8(const string& text) {
+    const unsigned char* source = reinterpret_cast<const unsigned char*>(text.data());
+    size_t length = text.size();
+    string folded(length, '\0');
+    unsigned char* target = reinterpret_cast<unsigned char*>(&folded[0]);
+
+    auto scalarByte = [&](size_t i) {
+        target[i] = foldUtf8Byte(i > 0 ? source[i - 1] : 0, source[i], i + 1 < length ? source[i + 1] : 0);
+    };
+
+    size_t i = 0;
+    if (length > 0) scalarByte(i++);
+#ifdef __SSE2__
+    for (; i + 17 <= length; i += 16) {
+        __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i - 1));
+        __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), foldUtf8Block(previous, current, next));
+    }
+#endif
+    for (; i < length; ++i) scalarByte(i);
+    return folded;
+}
+
+enum class NameMatch {
+    Exact,
+    IgnoreCase
+};
+
+enum class MemberKind {
+    Student = 1,
+    Professor = 2,
+    Staff = 3
+};
+
 class UniversityMember {
 protected:
     string fullName;
+    string foldedName;
     int memberId;
     int clearanceLevel;
 
@@ -39,19 +148,24 @@ protected:
 
 public:
     UniversityMember(const string& name, int id, int level)
-        : fullName(name), memberId(id), clearanceLevel(level) {
+        : fullName(name), foldedName(foldCaseUtf8(name)), memberId(id), clearanceLevel(level) {
         validate();
     }
 
     virtual ~UniversityMember() {}
 
+    virtual MemberKind getKind() const = 0;
+    virtual string getAffiliation() const = 0;
+
     string getFullName() const { return fullName; }
+    const string& getFoldedName() const { return foldedName; }
     int getMemberId() const { return memberId; }
     int getClearanceLevel() const { return clearanceLevel; }
 
     void setFullName(const string& name) {
         if (name.empty()) throw DataValidationError("ФИО обязательно для заполнения");
         fullName = name;
+        foldedName = foldCaseUtf8(name);
     }
 
     void setMemberId(int id) {
@@ -75,6 +189,7 @@ public:
 
     virtual void load(ifstream& file) {
         getline(file, fullName);
+        foldedName = foldCaseUtf8(fullName);
         file >> memberId >> clearanceLevel;
         file.ignore();
         validate();
@@ -96,6 +211,9 @@ public:
         cout << ", Статус: Студент, Группа: " << studyGroup << endl;
     }
 
+    MemberKind getKind() const override { return MemberKind::Student; }
+    string getAffiliation() const override { return studyGroup; }
+
     string getStudyGroup() const { return studyGroup; }
     void setStudyGroup(const string& group) {
         if (group.empty()) throw DataValidationError("Группа обязательна");
@@ -129,6 +247,9 @@ public:
         cout << ", Статус: Преподаватель, Кафедра: " << facultyDepartment << endl;
     }
 
+    MemberKind getKind() const override { return MemberKind::Professor; }
+    string getAffiliation() const override { return facultyDepartment; }
+
     string getFacultyDepartment() const { return facultyDepartment; }
     void setFacultyDepartment(const string& department) {
         if (department.empty()) throw DataValidationError("Кафедра обязательна");
@@ -162,69 +283,1675 @@ public:
         cout << ", Статус: Персонал, Должность: " << jobTitle << endl;
     }
 
-    string getJobTitle() const { return jobTitle; }
-    void setJobTitle(const string& title) {
-        if (title.empty()) throw DataValidationError("Должность обязательна");
-        jobTitle = title;
+    MemberKind getKind() const override { return MemberKind::Staff; }
+    string getAffiliation() const override { return jobTitle; }
+
+    string getJobTitle() const { return jobTitle; }
+    void setJobTitle(const string& title) {
+        if (title.empty()) throw DataValidationError("Должность обязательна");
+        jobTitle = title;
+    }
+
+    void save(ofstream& file) const override {
+        UniversityMember::save(file);
+        file << jobTitle << "\n";
+    }
+
+    void load(ifstream& file) override {
+        UniversityMember::load(file);
+        getline(file, jobTitle);
+        if (jobTitle.empty()) throw DataValidationError("Должность обязательна");
+    }
+};
+
+class CampusFacility {
+private:
+    string facilityName;
+    string foldedName;
+    int minAccessLevel;
+
+public:
+    CampusFacility(const string& name, int level)
+        : facilityName(name), foldedName(foldCaseUtf8(name)), minAccessLevel(level) {
+        if (facilityName.empty()) throw DataValidationError("Название обязательно");
+        if (level < 1 || level > 3) throw DataValidationError("Уровень доступа от 1 до 3");
+    }
+
+    string getFacilityName() const { return facilityName; }
+    const string& getFoldedName() const { return foldedName; }
+    int getMinAccessLevel() const { return minAccessLevel; }
+
+    void setFacilityName(const string& name) {
+        if (name.empty()) throw DataValidationError("Название обязательно");
+        facilityName = name;
+        foldedName = foldCaseUtf8(name);
+    }
+
+    void setMinAccessLevel(int level) {
+        if (level < 1 || level > 3) throw DataValidationError("Уровень доступа от 1 до 3");
+        minAccessLevel = level;
+    }
+
+    void showInfo() const {
+        cout << "Объект: " << facilityName
+            << ", Минимальный уровень доступа: " << minAccessLevel << endl;
+    }
+
+    bool verifyAccess(const UniversityMember& member) const {
+        return member.getClearanceLevel() >= minAccessLevel;
+    }
+
+    void save(ofstream& file) const {
+        file << facilityName << "\n" << minAccessLevel << "\n";
+    }
+
+    void load(ifstream& file) {
+        getline(file, facilityName);
+        foldedName = foldCaseUtf8(facilityName);
+        file >> minAccessLevel;
+        file.ignore();
+        if (facilityName.empty()) throw DataValidationError("Название обязательно");
+        if (minAccessLevel < 1 || minAccessLevel > 3)
+            throw DataValidationError("Уровень доступа от 1 до 3");
+    }
+};
+
+// Индекс шарда статистики для текущего потока: каждый поток пишет в свою
+// строку кэша, поэтому запись не требует блокировок и не конкурирует.
+const int STAT_SHARD_COUNT = 8;
+
+inline int currentStatShard() {
+    static atomic<int> nextShard{ 0 };
+    thread_local int shard = nextShard.fetch_add(1, memory_order_relaxed) % STAT_SHARD_COUNT;
+    return shard;
+}
+
+class ShardedCounter {
+private:
+    struct alignas(64) Cell {
+        atomic<uint64_t> value{ 0 };
+    };
+    Cell cells[STAT_SHARD_COUNT];
+
+public:
+    void increment() {
+        cells[currentStatShard()].value.fetch_add(1, memory_order_relaxed);
+    }
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (const auto& cell : cells) sum += cell.value.load(memory_order_relaxed);
+        return sum;
+    }
+
+    void reset() {
+        for (auto& cell : cells) cell.value.store(0, memory_order_relaxed);
+    }
+};
+
+// Гистограмма задержек в духе HDR: 16 линейных поддиапазонов на каждую
+// степень двойки (погрешность около 6%), значения в наносекундах.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 40;
+    static const int BUCKET_COUNT = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Summary {
+        uint64_t count;
+        uint64_t p50;
+        uint64_t p90;
+        uint64_t p99;
+        uint64_t max;
+    };
+
+private:
+    struct alignas(64) Shard {
+        atomic<uint64_t> buckets[BUCKET_COUNT];
+        atomic<uint64_t> maximum;
+    };
+    unique_ptr<Shard[]> shards;
+
+    static int bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<int>(value);
+        int exponent = static_cast<int>(bit_width(value)) - 1;
+        if (exponent > MAX_EXPONENT) return BUCKET_COUNT - 1;
+        int subBucket = static_cast<int>((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+        return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + subBucket;
+    }
+
+    static uint64_t bucketUpperBound(int index) {
+        if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+        int exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS;
+        uint64_t subBucket = static_cast<uint64_t>((index - SUB_BUCKETS) % SUB_BUCKETS);
+        return ((SUB_BUCKETS + subBucket + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+    }
+
+public:
+    LatencyHistogram() : shards(new Shard[STAT_SHARD_COUNT]) {
+        reset();
+    }
+
+    void record(uint64_t nanoseconds) {
+        Shard& shard = shards[currentStatShard()];
+        shard.buckets[bucketIndex(nanoseconds)].fetch_add(1, memory_order_relaxed);
+        uint64_t previous = shard.maximum.load(memory_order_relaxed);
+        while (nanoseconds > previous &&
+            !shard.maximum.compare_exchange_weak(previous, nanoseconds, memory_order_relaxed)) {
+        }
+    }
+
+    Summary summarize() const {
+        vector<uint64_t> merged(BUCKET_COUNT, 0);
+        Summary summary{ 0, 0, 0, 0, 0 };
+        for (int s = 0; s < STAT_SHARD_COUNT; ++s) {
+            for (int i = 0; i < BUCKET_COUNT; ++i) {
+                merged[i] += shards[s].buckets[i].load(memory_order_relaxed);
+            }
+            summary.max = max(summary.max, shards[s].maximum.load(memory_order_relaxed));
+        }
+        for (uint64_t bucket : merged) summary.count += bucket;
+        if (summary.count == 0) return summary;
+
+        auto percentile = [&](double fraction) {
+            uint64_t rank = static_cast<uint64_t>(fraction * summary.count + 0.5);
+            if (rank == 0) rank = 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKET_COUNT; ++i) {
+                seen += merged[i];
+                if (seen >= rank) return min(bucketUpperBound(i), summary.max);
+            }
+            return summary.max;
+        };
+        summary.p50 = percentile(0.50);
+        summary.p90 = percentile(0.90);
+        summary.p99 = percentile(0.99);
+        return summary;
+    }
+
+    void reset() {
+        for (int s = 0; s < STAT_SHARD_COUNT; ++s) {
+            for (auto& bucket : shards[s].buckets) bucket.store(0, memory_order_relaxed);
+            shards[s].maximum.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+enum class AccessOperation {
+    VerifyAccess,
+    LoadData,
+    SaveData,
+    FindByName,
+    FindById,
+    SortByLevel,
+    SortByName,
+    QueryMembers,
+    Count
+};
+
+inline const char* operationName(AccessOperation operation) {
+    switch (operation) {
+    case AccessOperation::VerifyAccess: return "verify_access";
+    case AccessOperation::LoadData: return "load_data";
+    case AccessOperation::SaveData: return "save_data";
+    case AccessOperation::FindByName: return "find_by_name";
+    case AccessOperation::FindById: return "find_by_id";
+    case AccessOperation::SortByLevel: return "sort_by_level";
+    case AccessOperation::SortByName: return "sort_by_name";
+    case AccessOperation::QueryMembers: return "query_members";
+    default: return "unknown";
+    }
+}
+
+class AccessStatistics {
+private:
+    LatencyHistogram histograms[static_cast<int>(AccessOperation::Count)];
+
+public:
+    ShardedCounter allowed;
+    ShardedCounter denied;
+    ShardedCounter unknown;
+    ShardedCounter lockedOut;
+
+    LatencyHistogram& histogram(AccessOperation operation) {
+        return histograms[static_cast<int>(operation)];
+    }
+
+    const LatencyHistogram& histogram(AccessOperation operation) const {
+        return histograms[static_cast<int>(operation)];
+    }
+
+    void reset() {
+        for (auto& h : histograms) h.reset();
+        allowed.reset();
+        denied.reset();
+        unknown.reset();
+        lockedOut.reset();
+    }
+};
+
+class ScopedLatency {
+private:
+    LatencyHistogram& histogram;
+    chrono::steady_clock::time_point started;
+
+public:
+    explicit ScopedLatency(LatencyHistogram& target)
+        : histogram(target), started(chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        auto elapsed = chrono::steady_clock::now() - started;
+        histogram.record(static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(elapsed).count()));
+    }
+};
+
+// Снимок данных в разделяемой памяти. Все ссылки внутри сегмента хранятся
+// как смещения от его начала, поэтому каждый процесс может отобразить сегмент
+// по любому адресу. Два слота чередуются: писатель заполняет неактивный слот
+// и переключает поколение, читатели проверяют номер последовательности слота
+// (нечётный во время записи) до и после чтения.
+const uint32_t REPLICA_MAGIC = 0x41434352;
+const uint32_t REPLICA_LAYOUT_VERSION = 1;
+
+struct ReplicaMember {
+    int32_t memberId;
+    int32_t clearanceLevel;
+    uint32_t kind;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t affiliationOffset;
+    uint32_t affiliationLength;
+};
+
+struct ReplicaFacility {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    int32_t minAccessLevel;
+};
+
+struct ReplicaSlot {
+    atomic<uint64_t> sequence;
+    uint64_t memberCount;
+    uint64_t facilityCount;
+    uint64_t membersOffset;
+    uint64_t facilitiesOffset;
+    uint64_t stringsOffset;
+};
+
+struct ReplicaHeader {
+    uint32_t magic;
+    uint32_t layoutVersion;
+    uint64_t slotCapacity;
+    atomic<uint64_t> generation;
+    uint64_t slotOffsets[2];
+};
+
+class SharedMemorySegment {
+private:
+    string segmentName;
+    void* address = nullptr;
+    size_t length = 0;
+
+public:
+    SharedMemorySegment(const string& name, size_t size, bool writable)
+        : segmentName(name) {
+#ifdef _WIN32
+        (void)size;
+        (void)writable;
+        throw runtime_error("Разделяемая память доступна только в POSIX-системах");
+#else
+        int descriptor = writable ? shm_open(name.c_str(), O_CREAT | O_RDWR, 0644)
+                                  : shm_open(name.c_str(), O_RDONLY, 0);
+        if (descriptor < 0) throw runtime_error("Не удалось открыть сегмент " + name);
+
+        if (writable) {
+            // Существующий сегмент другого размера не обрезается: его могут
+            // держать отображённым читатели, и обрезка уронила бы их.
+            struct stat info;
+            if (fstat(descriptor, &info) != 0) {
+                close(descriptor);
+                throw runtime_error("Не удалось прочитать размер сегмента " + name);
+            }
+            if (info.st_size != 0 && static_cast<size_t>(info.st_size) != size) {
+                close(descriptor);
+                throw runtime_error("Сегмент " + name + " уже существует и имеет другой размер");
+            }
+            if (ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+                close(descriptor);
+                throw runtime_error("Не удалось выделить сегмент " + name);
+            }
+            length = size;
+        }
+        else {
+            struct stat info;
+            if (fstat(descriptor, &info) != 0) {
+                close(descriptor);
+                throw runtime_error("Не удалось прочитать размер сегмента " + name);
+            }
+            length = static_cast<size_t>(info.st_size);
+        }
+
+        address = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+            MAP_SHARED, descriptor, 0);
+        close(descriptor);
+        if (address == MAP_FAILED) {
+            address = nullptr;
+            throw runtime_error("Не удалось отобразить сегмент " + name);
+        }
+#endif
+    }
+
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+    ~SharedMemorySegment() {
+#ifndef _WIN32
+        if (address) munmap(address, length);
+#endif
+    }
+
+    char* data() const { return static_cast<char*>(address); }
+    size_t size() const { return length; }
+    const string& name() const { return segmentName; }
+
+    // Удаляет имя сегмента; уже отображённые копии остаются у процессов до munmap.
+    static void unlink(const string& name) {
+#ifndef _WIN32
+        if (shm_unlink(name.c_str()) != 0 && errno != ENOENT) {
+            throw runtime_error("Не удалось удалить сегмент " + name);
+        }
+#else
+        (void)name;
+#endif
+    }
+};
+
+class SharedReplicaWriter {
+private:
+    SharedMemorySegment segment;
+
+    ReplicaHeader& header() const {
+        return *reinterpret_cast<ReplicaHeader*>(segment.data());
+    }
+
+public:
+    SharedReplicaWriter(const string& name, size_t slotCapacity = 4 << 20)
+        : segment(name, sizeof(ReplicaHeader) + 2 * slotCapacity, true) {
+        ReplicaHeader& h = header();
+        // Сегмент, оставшийся от прежнего писателя, продолжает нумерацию
+        // поколений: подключённые читатели не должны увидеть откат к нулю.
+        bool existing = h.magic == REPLICA_MAGIC && h.layoutVersion == REPLICA_LAYOUT_VERSION &&
+            h.slotCapacity == slotCapacity;
+        if (!existing) {
+            h.magic = REPLICA_MAGIC;
+            h.layoutVersion = REPLICA_LAYOUT_VERSION;
+            h.slotCapacity = slotCapacity;
+            h.slotOffsets[0] = sizeof(ReplicaHeader);
+            h.slotOffsets[1] = sizeof(ReplicaHeader) + slotCapacity;
+            h.generation.store(0, memory_order_release);
+        }
+    }
+
+    void unlink() const {
+        SharedMemorySegment::unlink(segment.name());
+    }
+
+    template<typename T>
+    uint64_t publish(const vector<unique_ptr<UniversityMember>>& members, const vector<T>& facilities) {
+        ReplicaHeader& h = header();
+        uint64_t nextGeneration = h.generation.load(memory_order_relaxed) + 1;
+        uint64_t slotOffset = h.slotOffsets[nextGeneration % 2];
+        ReplicaSlot& slot = *reinterpret_cast<ReplicaSlot*>(segment.data() + slotOffset);
+
+        vector<ReplicaMember> memberRecords;
+        vector<ReplicaFacility> facilityRecords;
+        string strings;
+        auto intern = [&strings](const string& text, uint32_t& offset, uint32_t& length) {
+            offset = static_cast<uint32_t>(strings.size());
+            length = static_cast<uint32_t>(text.size());
+            strings += text;
+        };
+
+        for (const auto& member : members) {
+            ReplicaMember record{};
+            record.memberId = member->getMemberId();
+            record.clearanceLevel = member->getClearanceLevel();
+            record.kind = static_cast<uint32_t>(member->getKind());
+            intern(member->getFullName(), record.nameOffset, record.nameLength);
+            intern(member->getAffiliation(), record.affiliationOffset, record.affiliationLength);
+            memberRecords.push_back(record);
+        }
+        sort(memberRecords.begin(), memberRecords.end(),
+            [](const ReplicaMember& a, const ReplicaMember& b) { return a.memberId < b.memberId; });
+
+        for (const auto& facility : facilities) {
+            ReplicaFacility record{};
+            record.minAccessLevel = facility.getMinAccessLevel();
+            intern(facility.getFacilityName(), record.nameOffset, record.nameLength);
+            facilityRecords.push_back(record);
+        }
+
+        uint64_t membersOffset = sizeof(ReplicaSlot);
+        uint64_t facilitiesOffset = membersOffset + memberRecords.size() * sizeof(ReplicaMember);
+        uint64_t stringsOffset = facilitiesOffset + facilityRecords.size() * sizeof(ReplicaFacility);
+        if (stringsOffset + strings.size() > h.slotCapacity) {
+            throw runtime_error("Данные не помещаются в сегмент " + segment.name());
+        }
+
+        uint64_t sequence = slot.sequence.load(memory_order_relaxed);
+        slot.sequence.store(sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        char* base = reinterpret_cast<char*>(&slot);
+        memcpy(base + membersOffset, memberRecords.data(), memberRecords.size() * sizeof(ReplicaMember));
+        memcpy(base + facilitiesOffset, facilityRecords.data(), facilityRecords.size() * sizeof(ReplicaFacility));
+        memcpy(base + stringsOffset, strings.data(), strings.size());
+        slot.memberCount = memberRecords.size();
+        slot.facilityCount = facilityRecords.size();
+        slot.membersOffset = membersOffset;
+        slot.facilitiesOffset = facilitiesOffset;
+        slot.stringsOffset = stringsOffset;
+
+        slot.sequence.store(sequence + 2, memory_order_release);
+        h.generation.store(nextGeneration, memory_order_release);
+        return nextGeneration;
+    }
+};
+
+class SharedReplicaReader {
+private:
+    SharedMemorySegment segment;
+
+    const ReplicaHeader& header() const {
+        return *reinterpret_cast<const ReplicaHeader*>(segment.data());
+    }
+
+public:
+    static const int MAX_READ_ATTEMPTS = 10000;
+
+    explicit SharedReplicaReader(const string& name) : segment(name, 0, false) {
+        if (segment.size() < sizeof(ReplicaHeader) || header().magic != REPLICA_MAGIC ||
+            header().layoutVersion != REPLICA_LAYOUT_VERSION) {
+            throw runtime_error("Сегмент " + name + " не содержит реплики");
+        }
+        const ReplicaHeader& h = header();
+        for (uint64_t slotOffset : h.slotOffsets) {
+            if (h.slotCapacity < sizeof(ReplicaSlot) || slotOffset < sizeof(ReplicaHeader) ||
+                slotOffset > segment.size() || h.slotCapacity > segment.size() - slotOffset ||
+                slotOffset % alignof(ReplicaSlot) != 0) {
+                throw runtime_error("Сегмент " + name + " повреждён");
+            }
+        }
+    }
+
+    uint64_t generation() const {
+        return header().generation.load(memory_order_acquire);
+    }
+
+    // Поля слота читаются без блокировки и могут оказаться разорванными, если
+    // писатель успел заново занять слот. Поэтому каждое смещение и длина
+    // сначала проверяются по границам слота; не прошедший проверку снимок
+    // перечитывается, а устойчиво неверный считается повреждённым.
+    bool verifyMemberAccess(int memberId, const string& facilityName) const {
+        const ReplicaHeader& h = header();
+        const uint64_t capacity = h.slotCapacity;
+        for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+            uint64_t currentGeneration = h.generation.load(memory_order_acquire);
+            if (currentGeneration == 0) throw runtime_error("Реплика ещё не опубликована");
+
+            const char* base = segment.data() + h.slotOffsets[currentGeneration % 2];
+            const ReplicaSlot& slot = *reinterpret_cast<const ReplicaSlot*>(base);
+            uint64_t before = slot.sequence.load(memory_order_acquire);
+            if (before % 2 != 0) {
+                this_thread::yield();
+                continue;
+            }
+
+            const uint64_t memberCount = slot.memberCount;
+            const uint64_t facilityCount = slot.facilityCount;
+            const uint64_t membersOffset = slot.membersOffset;
+            const uint64_t facilitiesOffset = slot.facilitiesOffset;
+            const uint64_t stringsOffset = slot.stringsOffset;
+            auto sequenceChanged = [&] {
+                atomic_thread_fence(memory_order_acquire);
+                return slot.sequence.load(memory_order_relaxed) != before;
+            };
+            auto arrayFits = [capacity](uint64_t offset, uint64_t count, size_t recordSize, size_t alignment) {
+                return offset >= sizeof(ReplicaSlot) && offset <= capacity && offset % alignment == 0 &&
+                    count <= (capacity - offset) / recordSize;
+            };
+            if (!arrayFits(membersOffset, memberCount, sizeof(ReplicaMember), alignof(ReplicaMember)) ||
+                !arrayFits(facilitiesOffset, facilityCount, sizeof(ReplicaFacility), alignof(ReplicaFacility)) ||
+                stringsOffset > capacity) {
+                if (sequenceChanged()) continue;
+                throw runtime_error("Реплика повреждена");
+            }
+            const uint64_t stringsSize = capacity - stringsOffset;
+            auto stringFits = [stringsSize](uint32_t offset, uint32_t length) {
+                return offset <= stringsSize && length <= stringsSize - offset;
+            };
+
+            const ReplicaMember* members = reinterpret_cast<const ReplicaMember*>(base + membersOffset);
+            const ReplicaFacility* facilities = reinterpret_cast<const ReplicaFacility*>(base + facilitiesOffset);
+            const char* strings = base + stringsOffset;
+
+            const ReplicaMember* memberEnd = members + memberCount;
+            const ReplicaMember* member = lower_bound(members, memberEnd, memberId,
+                [](const ReplicaMember& m, int id) { return m.memberId < id; });
+            bool memberFound = member != memberEnd && member->memberId == memberId;
+
+            bool boundsValid = true;
+            const ReplicaFacility* facility = nullptr;
+            for (uint64_t i = 0; i < facilityCount; ++i) {
+                ReplicaFacility record = facilities[i];
+                if (!stringFits(record.nameOffset, record.nameLength)) {
+                    boundsValid = false;
+                    break;
+                }
+                if (string_view(strings + record.nameOffset, record.nameLength) == facilityName) {
+                    facility = &facilities[i];
+                    break;
+                }
+            }
+            bool allowed = boundsValid && memberFound && facility && member->clearanceLevel >= facility->minAccessLevel;
+            string memberName;
+            if (boundsValid && memberFound && !allowed) {
+                ReplicaMember record = *member;
+                if (stringFits(record.nameOffset, record.nameLength)) {
+                    memberName.assign(strings + record.nameOffset, record.nameLength);
+                }
+                else {
+                    boundsValid = false;
+                }
+            }
+
+            if (sequenceChanged()) continue;
+            if (!boundsValid) throw runtime_error("Реплика повреждена");
+
+            if (!memberFound) {
+                throw runtime_error("Член университета с ID " + to_string(memberId) + " не найден");
+            }
+            if (!facility) {
+                throw runtime_error("Объект " + facilityName + " не найден");
+            }
+            if (!allowed) {
+                throw AccessViolationError("Доступ запрещен для " + memberName +
+                    " к объекту " + facilityName);
+            }
+            return true;
+        }
+        throw runtime_error("Реплика недоступна: писатель не завершает публикацию");
+    }
+};
+
+enum class MemberField {
+    Id,
+    ClearanceLevel,
+    Kind,
+    Affiliation
+};
+
+enum class CompareOp {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+// Выражение фильтра: сравнения и списки IN по полям члена университета,
+// объединяемые через && и ||. Строковые значения допустимы только для
+// группы/кафедры/должности.
+class MemberFilter {
+public:
+    enum class NodeType { Compare, In, And, Or };
+
+    struct Node {
+        NodeType type;
+        MemberField field;
+        CompareOp op;
+        vector<int> numbers;
+        vector<string> texts;
+        shared_ptr<const Node> left;
+        shared_ptr<const Node> right;
+    };
+
+private:
+    shared_ptr<const Node> root;
+
+    explicit MemberFilter(shared_ptr<const Node> node) : root(move(node)) {}
+
+    static Node leaf(NodeType type, MemberField field, CompareOp op) {
+        Node node{ type, field, op, {}, {}, nullptr, nullptr };
+        return node;
+    }
+
+public:
+    static MemberFilter where(MemberField field, CompareOp op, int value) {
+        if (field == MemberField::Affiliation) throw DataValidationError("Для этого поля нужно строковое значение");
+        Node node = leaf(NodeType::Compare, field, op);
+        node.numbers.push_back(value);
+        return MemberFilter(make_shared<const Node>(move(node)));
+    }
+
+    static MemberFilter where(MemberField field, CompareOp op, const string& value) {
+        if (field != MemberField::Affiliation) throw DataValidationError("Для этого поля нужно числовое значение");
+        if (op != CompareOp::Equal && op != CompareOp::NotEqual) {
+            throw DataValidationError("Строки сравниваются только на равенство");
+        }
+        Node node = leaf(NodeType::Compare, field, op);
+        node.texts.push_back(value);
+        return MemberFilter(make_shared<const Node>(move(node)));
+    }
+
+    static MemberFilter in(MemberField field, vector<int> values) {
+        if (field == MemberField::Affiliation) throw DataValidationError("Для этого поля нужно строковое значение");
+        Node node = leaf(NodeType::In, field, CompareOp::Equal);
+        node.numbers = move(values);
+        return MemberFilter(make_shared<const Node>(move(node)));
+    }
+
+    static MemberFilter in(MemberField field, vector<string> values) {
+        if (field != MemberField::Affiliation) throw DataValidationError("Для этого поля нужно числовое значение");
+        Node node = leaf(NodeType::In, field, CompareOp::Equal);
+        node.texts = move(values);
+        return MemberFilter(make_shared<const Node>(move(node)));
+    }
+
+    MemberFilter operator&&(const MemberFilter& other) const {
+        Node node = leaf(NodeType::And, MemberField::Id, CompareOp::Equal);
+        node.left = root;
+        node.right = other.root;
+        return MemberFilter(make_shared<const Node>(move(node)));
+    }
+
+    MemberFilter operator||(const MemberFilter& other) const {
+        Node node = leaf(NodeType::Or, MemberField::Id, CompareOp::Equal);
+        node.left = root;
+        node.right = other.root;
+        return MemberFilter(make_shared<const Node>(move(node)));
+    }
+
+    const Node& node() const { return *root; }
+};
+
+class SelectionBitmap {
+private:
+    vector<uint64_t> words;
+    size_t rowCount;
+
+public:
+    explicit SelectionBitmap(size_t rows) : words((rows + 63) / 64, 0), rowCount(rows) {}
+
+    size_t rows() const { return rowCount; }
+    uint64_t& word(size_t index) { return words[index]; }
+
+    void set(size_t row) { words[row / 64] |= uint64_t(1) << (row % 64); }
+    bool test(size_t row) const { return (words[row / 64] >> (row % 64)) & 1; }
+
+    void intersect(const SelectionBitmap& other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] &= other.words[i];
+    }
+
+    void unite(const SelectionBitmap& other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] |= other.words[i];
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t w : words) total += static_cast<size_t>(popcount(w));
+        return total;
+    }
+
+    template<typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            uint64_t w = words[i];
+            while (w) {
+                visit(i * 64 + static_cast<size_t>(countr_zero(w)));
+                w &= w - 1;
+            }
+        }
+    }
+};
+
+// Столбцовое представление членов для фильтров: по вектору на поле, словарь
+// для строковых атрибутов и два индекса (отсортированные ID и списки строк
+// по группе/кафедре/должности).
+class MemberColumns {
+public:
+    vector<int32_t> ids;
+    vector<int32_t> levels;
+    vector<int32_t> kinds;
+    vector<int32_t> affiliations;
+    unordered_map<string, int32_t> affiliationCodes;
+    vector<pair<int32_t, uint32_t>> idIndex;
+    vector<vector<uint32_t>> affiliationRows;
+
+    size_t rows() const { return ids.size(); }
+
+    void rebuild(const vector<unique_ptr<UniversityMember>>& members) {
+        ids.clear();
+        levels.clear();
+        kinds.clear();
+        affiliations.clear();
+        affiliationCodes.clear();
+        idIndex.clear();
+        affiliationRows.clear();
+
+        for (size_t row = 0; row < members.size(); ++row) {
+            const auto& member = members[row];
+            ids.push_back(member->getMemberId());
+            levels.push_back(member->getClearanceLevel());
+            kinds.push_back(static_cast<int32_t>(member->getKind()));
+
+            auto code = affiliationCodes.emplace(member->getAffiliation(),
+                static_cast<int32_t>(affiliationCodes.size())).first->second;
+            if (code == static_cast<int32_t>(affiliationRows.size())) affiliationRows.emplace_back();
+            affiliations.push_back(code);
+            affiliationRows[code].push_back(static_cast<uint32_t>(row));
+            idIndex.emplace_back(member->getMemberId(), static_cast<uint32_t>(row));
+        }
+        sort(idIndex.begin(), idIndex.end());
+    }
+
+    int32_t codeOf(const string& text) const {
+        auto it = affiliationCodes.find(text);
+        return it == affiliationCodes.end() ? -1 : it->second;
+    }
+
+    const vector<int32_t>& column(MemberField field) const {
+        switch (field) {
+        case MemberField::Id: return ids;
+        case MemberField::ClearanceLevel: return levels;
+        case MemberField::Kind: return kinds;
+        default: return affiliations;
+        }
+    }
+};
+
+inline bool compareValues(int32_t value, CompareOp op, int32_t operand) {
+    switch (op) {
+    case CompareOp::Equal: return value == operand;
+    case CompareOp::NotEqual: return value != operand;
+    case CompareOp::Less: return value < operand;
+    case CompareOp::LessEqual: return value <= operand;
+    case CompareOp::Greater: return value > operand;
+    default: return value >= operand;
+    }
+}
+
+inline const char* fieldName(MemberField field) {
+    switch (field) {
+    case MemberField::Id: return "id";
+    case MemberField::ClearanceLevel: return "level";
+    case MemberField::Kind: return "kind";
+    default: return "affiliation";
+    }
+}
+
+// Проверка столбца блоками по 64 строки: сначала байтовые флаги без ветвлений
+// (этот цикл компилятор векторизует), затем упаковка блока в слово битовой карты.
+template<typename Predicate>
+SelectionBitmap scanColumn(const vector<int32_t>& column, Predicate predicate) {
+    SelectionBitmap result(column.size());
+    const int32_t* values = column.data();
+    for (size_t base = 0, block = 0; base < column.size(); base += 64, ++block) {
+        size_t width = min<size_t>(64, column.size() - base);
+        uint8_t matches[64] = {};
+        for (size_t j = 0; j < width; ++j) matches[j] = predicate(values[base + j]) ? 1 : 0;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; ++j) word |= uint64_t(matches[j]) << j;
+        result.word(block) = word;
+    }
+    return result;
+}
+
+class QueryPlanNode {
+public:
+    virtual ~QueryPlanNode() {}
+    virtual SelectionBitmap execute(const MemberColumns& columns) const = 0;
+    virtual bool matchesRow(const MemberColumns& columns, size_t row) const = 0;
+    virtual size_t estimate(const MemberColumns& columns) const { return columns.rows(); }
+    virtual bool usesIndex() const { return false; }
+    virtual void describe(ostream& out) const = 0;
+};
+
+class ComparisonScan : public QueryPlanNode {
+private:
+    MemberField field;
+    CompareOp op;
+    int32_t operand;
+
+public:
+    ComparisonScan(MemberField f, CompareOp o, int32_t value) : field(f), op(o), operand(value) {}
+
+    SelectionBitmap execute(const MemberColumns& columns) const override {
+        const auto& column = columns.column(field);
+        int32_t v = operand;
+        switch (op) {
+        case CompareOp::Equal: return scanColumn(column, [v](int32_t x) { return x == v; });
+        case CompareOp::NotEqual: return scanColumn(column, [v](int32_t x) { return x != v; });
+        case CompareOp::Less: return scanColumn(column, [v](int32_t x) { return x < v; });
+        case CompareOp::LessEqual: return scanColumn(column, [v](int32_t x) { return x <= v; });
+        case CompareOp::Greater: return scanColumn(column, [v](int32_t x) { return x > v; });
+        default: return scanColumn(column, [v](int32_t x) { return x >= v; });
+        }
+    }
+
+    bool matchesRow(const MemberColumns& columns, size_t row) const override {
+        return compareValues(columns.column(field)[row], op, operand);
+    }
+
+    void describe(ostream& out) const override {
+        static const char* symbols[] = { "=", "!=", "<", "<=", ">", ">=" };
+        out << "scan(" << fieldName(field) << " " << symbols[static_cast<int>(op)] << " " << operand << ")";
+    }
+};
+
+class InListScan : public QueryPlanNode {
+private:
+    MemberField field;
+    vector<int32_t> values;
+
+public:
+    InListScan(MemberField f, vector<int32_t> list) : field(f), values(move(list)) {}
+
+    SelectionBitmap execute(const MemberColumns& columns) const override {
+        SelectionBitmap result(columns.rows());
+        for (int32_t v : values) {
+            result.unite(scanColumn(columns.column(field), [v](int32_t x) { return x == v; }));
+        }
+        return result;
+    }
+
+    bool matchesRow(const MemberColumns& columns, size_t row) const override {
+        return find(values.begin(), values.end(), columns.column(field)[row]) != values.end();
+    }
+
+    void describe(ostream& out) const override {
+        out << "scan(" << fieldName(field) << " in " << values.size() << " values)";
+    }
+};
+
+// Поиск по отсортированному индексу ID: каждое условие сводится к набору
+// полуинтервалов [from, to).
+class IdIndexLookup : public QueryPlanNode {
+private:
+    vector<pair<int64_t, int64_t>> ranges;
+
+    template<typename Visitor>
+    void forEachEntry(const MemberColumns& columns, Visitor visit) const {
+        const auto& index = columns.idIndex;
+        for (const auto& range : ranges) {
+            auto first = lower_bound(index.begin(), index.end(), range.first,
+                [](const pair<int32_t, uint32_t>& e, int64_t id) { return e.first < id; });
+            auto last = lower_bound(first, index.end(), range.second,
+                [](const pair<int32_t, uint32_t>& e, int64_t id) { return e.first < id; });
+            for (auto it = first; it != last; ++it) visit(it->second);
+        }
+    }
+
+public:
+    explicit IdIndexLookup(vector<pair<int64_t, int64_t>> idRanges) : ranges(move(idRanges)) {}
+
+    SelectionBitmap execute(const MemberColumns& columns) const override {
+        SelectionBitmap result(columns.rows());
+        forEachEntry(columns, [&result](uint32_t row) { result.set(row); });
+        return result;
+    }
+
+    bool matchesRow(const MemberColumns& columns, size_t row) const override {
+        int64_t id = columns.ids[row];
+        for (const auto& range : ranges) {
+            if (id >= range.first && id < range.second) return true;
+        }
+        return false;
+    }
+
+    size_t estimate(const MemberColumns& columns) const override {
+        size_t total = 0;
+        forEachEntry(columns, [&total](uint32_t) { ++total; });
+        return total;
+    }
+
+    bool usesIndex() const override { return true; }
+
+    void describe(ostream& out) const override {
+        out << "index(id, " << ranges.size() << " ranges)";
+    }
+};
+
+class AffiliationIndexLookup : public QueryPlanNode {
+private:
+    vector<int32_t> codes;
+
+public:
+    explicit AffiliationIndexLookup(vector<int32_t> list) : codes(move(list)) {}
+
+    SelectionBitmap execute(const MemberColumns& columns) const override {
+        SelectionBitmap result(columns.rows());
+        for (int32_t code : codes) {
+            for (uint32_t row : columns.affiliationRows[code]) result.set(row);
+        }
+        return result;
+    }
+
+    bool matchesRow(const MemberColumns& columns, size_t row) const override {
+        return find(codes.begin(), codes.end(), columns.affiliations[row]) != codes.end();
+    }
+
+    size_t estimate(const MemberColumns& columns) const override {
+        size_t total = 0;
+        for (int32_t code : codes) total += columns.affiliationRows[code].size();
+        return total;
+    }
+
+    bool usesIndex() const override { return true; }
+
+    void describe(ostream& out) const override {
+        out << "index(affiliation, " << codes.size() << " keys)";
+    }
+};
+
+class AndNode : public QueryPlanNode {
+private:
+    vector<unique_ptr<QueryPlanNode>> children;
+
+public:
+    explicit AndNode(vector<unique_ptr<QueryPlanNode>> parts) : children(move(parts)) {}
+
+    // Если самый избирательный операнд идёт через индекс, остальные условия
+    // проверяются только для найденных им строк; иначе битовые карты сканов
+    // пересекаются целиком.
+    SelectionBitmap execute(const MemberColumns& columns) const override {
+        if (children.front()->usesIndex()) {
+            SelectionBitmap candidates = children.front()->execute(columns);
+            SelectionBitmap result(columns.rows());
+            candidates.forEach([&](size_t row) {
+                for (size_t i = 1; i < children.size(); ++i) {
+                    if (!children[i]->matchesRow(columns, row)) return;
+                }
+                result.set(row);
+            });
+            return result;
+        }
+        SelectionBitmap result = children.front()->execute(columns);
+        for (size_t i = 1; i < children.size(); ++i) result.intersect(children[i]->execute(columns));
+        return result;
+    }
+
+    bool matchesRow(const MemberColumns& columns, size_t row) const override {
+        for (const auto& child : children) {
+            if (!child->matchesRow(columns, row)) return false;
+        }
+        return true;
+    }
+
+    size_t estimate(const MemberColumns& columns) const override {
+        return children.front()->estimate(columns);
+    }
+
+    bool usesIndex() const override { return children.front()->usesIndex(); }
+
+    void describe(ostream& out) const override {
+        out << "and(";
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (i) out << ", ";
+            children[i]->describe(out);
+        }
+        out << ")";
+    }
+};
+
+class OrNode : public QueryPlanNode {
+private:
+    unique_ptr<QueryPlanNode> left;
+    unique_ptr<QueryPlanNode> right;
+
+public:
+    OrNode(unique_ptr<QueryPlanNode> a, unique_ptr<QueryPlanNode> b) : left(move(a)), right(move(b)) {}
+
+    SelectionBitmap execute(const MemberColumns& columns) const override {
+        SelectionBitmap result = left->execute(columns);
+        result.unite(right->execute(columns));
+        return result;
+    }
+
+    bool matchesRow(const MemberColumns& columns, size_t row) const override {
+        return left->matchesRow(columns, row) || right->matchesRow(columns, row);
+    }
+
+    size_t estimate(const MemberColumns& columns) const override {
+        return min(columns.rows(), left->estimate(columns) + right->estimate(columns));
+    }
+
+    bool usesIndex() const override { return left->usesIndex() && right->usesIndex(); }
+
+    void describe(ostream& out) const override {
+        out << "or(";
+        left->describe(out);
+        out << ", ";
+        right->describe(out);
+        out << ")";
+    }
+};
+
+class MemberQueryPlan {
+private:
+    unique_ptr<QueryPlanNode> root;
+
+    // Индекс берётся, если по оценке он отбирает не больше восьмой части строк.
+    static bool selective(const QueryPlanNode& node, const MemberColumns& columns) {
+        return node.estimate(columns) * 8 <= columns.rows();
+    }
+
+    static unique_ptr<QueryPlanNode> chooseAccess(unique_ptr<QueryPlanNode> indexed,
+        unique_ptr<QueryPlanNode> scan, const MemberColumns& columns) {
+        return selective(*indexed, columns) ? move(indexed) : move(scan);
+    }
+
+    static bool isIdRange(const MemberFilter::Node& node) {
+        return node.type == MemberFilter::NodeType::Compare && node.field == MemberField::Id &&
+            node.op != CompareOp::NotEqual;
+    }
+
+    static pair<int64_t, int64_t> idRangeOf(const MemberFilter::Node& node) {
+        int64_t value = node.numbers.front();
+        switch (node.op) {
+        case CompareOp::Equal: return { value, value + 1 };
+        case CompareOp::Less: return { INT32_MIN, value };
+        case CompareOp::LessEqual: return { INT32_MIN, value + 1 };
+        case CompareOp::Greater: return { value + 1, int64_t(INT32_MAX) + 1 };
+        default: return { value, int64_t(INT32_MAX) + 1 };
+        }
+    }
+
+    // Диапазон ID [from, to): поиск по индексу либо пара сравнений при скане.
+    static unique_ptr<QueryPlanNode> idRangeAccess(pair<int64_t, int64_t> range, const MemberColumns& columns) {
+        range = { max<int64_t>(range.first, INT32_MIN), min<int64_t>(range.second, int64_t(INT32_MAX) + 1) };
+        if (range.first >= range.second) range = { 0, 0 };
+        vector<unique_ptr<QueryPlanNode>> scans;
+        scans.push_back(make_unique<ComparisonScan>(MemberField::Id, CompareOp::GreaterEqual,
+            static_cast<int32_t>(range.first)));
+        scans.push_back(make_unique<ComparisonScan>(MemberField::Id, CompareOp::LessEqual,
+            static_cast<int32_t>(range.second - 1)));
+        return chooseAccess(make_unique<IdIndexLookup>(vector<pair<int64_t, int64_t>>{ range }),
+            make_unique<AndNode>(move(scans)), columns);
+    }
+
+    static void collectAnd(const MemberFilter::Node& node, vector<const MemberFilter::Node*>& out) {
+        if (node.type == MemberFilter::NodeType::And) {
+            collectAnd(*node.left, out);
+            collectAnd(*node.right, out);
+        }
+        else {
+            out.push_back(&node);
+        }
+    }
+
+    static unique_ptr<QueryPlanNode> compile(const MemberFilter::Node& node, const MemberColumns& columns) {
+        switch (node.type) {
+        case MemberFilter::NodeType::And: {
+            vector<const MemberFilter::Node*> parts;
+            collectAnd(node, parts);
+            vector<unique_ptr<QueryPlanNode>> children;
+            pair<int64_t, int64_t> idRange(INT64_MIN, INT64_MAX);
+            bool hasIdRange = false;
+            for (const auto* part : parts) {
+                if (isIdRange(*part)) {
+                    auto range = idRangeOf(*part);
+                    idRange = { max(idRange.first, range.first), min(idRange.second, range.second) };
+                    hasIdRange = true;
+                }
+                else {
+                    children.push_back(compile(*part, columns));
+                }
+            }
+            if (hasIdRange) children.push_back(idRangeAccess(idRange, columns));
+            stable_sort(children.begin(), children.end(),
+                [&columns](const auto& a, const auto& b) {
+                    return a->estimate(columns) < b->estimate(columns);
+                });
+            return make_unique<AndNode>(move(children));
+        }
+        case MemberFilter::NodeType::Or:
+            return make_unique<OrNode>(compile(*node.left, columns), compile(*node.right, columns));
+        case MemberFilter::NodeType::In: {
+            if (node.field == MemberField::Affiliation) {
+                vector<int32_t> codes;
+                for (const auto& text : node.texts) {
+                    int32_t code = columns.codeOf(text);
+                    if (code >= 0) codes.push_back(code);
+                }
+                return chooseAccess(make_unique<AffiliationIndexLookup>(codes),
+                    make_unique<InListScan>(node.field, codes), columns);
+            }
+            vector<int32_t> values(node.numbers.begin(), node.numbers.end());
+            if (node.field == MemberField::Id) {
+                vector<pair<int64_t, int64_t>> ranges;
+                for (int32_t id : values) ranges.emplace_back(id, int64_t(id) + 1);
+                return chooseAccess(make_unique<IdIndexLookup>(move(ranges)),
+                    make_unique<InListScan>(node.field, values), columns);
+            }
+            return make_unique<InListScan>(node.field, move(values));
+        }
+        default:
+            break;
+        }
+
+        if (node.field == MemberField::Affiliation) {
+            int32_t code = columns.codeOf(node.texts.front());
+            if (node.op == CompareOp::Equal) {
+                vector<int32_t> codes;
+                if (code >= 0) codes.push_back(code);
+                return chooseAccess(make_unique<AffiliationIndexLookup>(codes),
+                    make_unique<InListScan>(node.field, codes), columns);
+            }
+            return make_unique<ComparisonScan>(node.field, CompareOp::NotEqual, code);
+        }
+
+        if (isIdRange(node)) return idRangeAccess(idRangeOf(node), columns);
+        return make_unique<ComparisonScan>(node.field, node.op, node.numbers.front());
+    }
+
+public:
+    MemberQueryPlan(const MemberFilter& filter, const MemberColumns& columns)
+        : root(compile(filter.node(), columns)) {}
+
+    SelectionBitmap execute(const MemberColumns& columns) const {
+        return root->execute(columns);
+    }
+
+    void describe(ostream& out) const {
+        root->describe(out);
+    }
+};
+
+enum class AccessDecision {
+    Allowed,
+    Denied,
+    UnknownMember,
+    UnknownFacility,
+    LockedOut
+};
+
+// Таблица счётчиков отказов с открытой адресацией без блокировок: ключ
+// занимается через CAS, у каждого ключа кольцо из threshold последних
+// отметок времени. Если самая старая отметка кольца ещё внутри окна, порог
+// достигнут. Заполненная таблица перестаёт заводить новые ключи.
+class DenialCounterTable {
+public:
+    static const int MAX_THRESHOLD = 16;
+
+private:
+    static const int64_t EMPTY_KEY = INT64_MIN;
+
+    struct alignas(64) Entry {
+        atomic<int64_t> key{ EMPTY_KEY };
+        atomic<uint32_t> next{ 0 };
+        atomic<int64_t> lockedUntil{ 0 };
+        atomic<int64_t> stamps[MAX_THRESHOLD];
+    };
+
+    unique_ptr<Entry[]> entries;
+    size_t capacity;
+    int threshold;
+
+    size_t slotOf(int64_t key) const {
+        return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> 20) & (capacity - 1);
+    }
+
+    Entry* locate(int64_t key, bool create) const {
+        size_t slot = slotOf(key);
+        for (size_t probe = 0; probe < capacity; ++probe) {
+            Entry& entry = entries[(slot + probe) & (capacity - 1)];
+            int64_t current = entry.key.load(memory_order_acquire);
+            if (current == key) return &entry;
+            if (current == EMPTY_KEY) {
+                if (!create) return nullptr;
+                if (entry.key.compare_exchange_strong(current, key, memory_order_acq_rel) || current == key) {
+                    return &entry;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    DenialCounterTable(size_t slots, int ringSize)
+        : entries(new Entry[slots]), capacity(slots), threshold(ringSize) {
+        if (slots == 0 || (slots & (slots - 1)) != 0) throw DataValidationError("Размер таблицы - степень двойки");
+        if (ringSize < 1 || ringSize > MAX_THRESHOLD) {
+            throw DataValidationError("Порог блокировки от 1 до " + to_string(MAX_THRESHOLD));
+        }
+        clear();
+    }
+
+    void clear() {
+        for (size_t i = 0; i < capacity; ++i) {
+            entries[i].key.store(EMPTY_KEY, memory_order_relaxed);
+            entries[i].next.store(0, memory_order_relaxed);
+            entries[i].lockedUntil.store(0, memory_order_relaxed);
+            for (auto& stamp : entries[i].stamps) stamp.store(0, memory_order_relaxed);
+        }
+    }
+
+    // Возвращает true, если эта отметка довела счётчик до порога в окне.
+    bool recordDenial(int64_t key, int64_t now, int64_t windowMs, int64_t lockoutMs) {
+        Entry* entry = locate(key, true);
+        if (!entry) return false;
+        uint32_t index = entry->next.fetch_add(1, memory_order_relaxed) % threshold;
+        entry->stamps[index].store(now, memory_order_relaxed);
+        int64_t oldest = entry->stamps[(index + 1) % threshold].load(memory_order_relaxed);
+        if (oldest != 0 && now - oldest <= windowMs) {
+            entry->lockedUntil.store(now + lockoutMs, memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    int64_t lockedUntil(int64_t key) const {
+        Entry* entry = locate(key, false);
+        return entry ? entry->lockedUntil.load(memory_order_acquire) : 0;
+    }
+
+    int denialsInWindow(int64_t key, int64_t now, int64_t windowMs) const {
+        Entry* entry = locate(key, false);
+        if (!entry) return 0;
+        int count = 0;
+        for (int i = 0; i < threshold; ++i) {
+            int64_t stamp = entry->stamps[i].load(memory_order_relaxed);
+            if (stamp != 0 && now - stamp <= windowMs) ++count;
+        }
+        return count;
+    }
+
+    void restore(int64_t key, int64_t until, const vector<int64_t>& stamps) {
+        Entry* entry = locate(key, true);
+        if (!entry) return;
+        entry->lockedUntil.store(until, memory_order_relaxed);
+        for (int64_t stamp : stamps) {
+            uint32_t index = entry->next.fetch_add(1, memory_order_relaxed) % threshold;
+            entry->stamps[index].store(stamp, memory_order_relaxed);
+        }
+    }
+
+    template<typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t i = 0; i < capacity; ++i) {
+            const Entry& entry = entries[i];
+            int64_t key = entry.key.load(memory_order_acquire);
+            if (key == EMPTY_KEY) continue;
+            vector<int64_t> stamps;
+            for (int j = 0; j < threshold; ++j) {
+                int64_t stamp = entry.stamps[j].load(memory_order_relaxed);
+                if (stamp != 0) stamps.push_back(stamp);
+            }
+            sort(stamps.begin(), stamps.end());
+            visit(key, entry.lockedUntil.load(memory_order_relaxed), stamps);
+        }
+    }
+};
+
+// Временная блокировка пропуска после серии отказов: threshold отказов
+// за windowSeconds блокируют пропуск на lockoutSeconds. Счётчики по объектам
+// ведутся для отчётов и блокировок не вызывают.
+class DenialLockout {
+private:
+    int threshold;
+    int64_t windowMs;
+    int64_t lockoutMs;
+    DenialCounterTable memberCounters;
+    DenialCounterTable facilityCounters;
+
+    static int64_t facilityKey(const string& facilityName) {
+        return static_cast<int64_t>(hash<string>{}(facilityName) & 0x7FFFFFFFFFFFFFFFull);
+    }
+
+public:
+    DenialLockout(int denialThreshold = 5, int windowSeconds = 60, int lockoutSeconds = 300)
+        : threshold(denialThreshold), windowMs(windowSeconds * 1000LL), lockoutMs(lockoutSeconds * 1000LL),
+          memberCounters(1024, denialThreshold), facilityCounters(256, denialThreshold) {
+        if (windowSeconds <= 0 || lockoutSeconds <= 0) throw DataValidationError("Интервалы блокировки должны быть положительными");
+    }
+
+    static int64_t nowMs() {
+        return chrono::duration_cast<chrono::milliseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int getThreshold() const { return threshold; }
+    int64_t getWindowMs() const { return windowMs; }
+    int64_t getLockoutMs() const { return lockoutMs; }
+
+    bool isLocked(int memberId, int64_t now) const {
+        return memberCounters.lockedUntil(memberId) > now;
+    }
+
+    int64_t remainingMs(int memberId, int64_t now) const {
+        return max<int64_t>(0, memberCounters.lockedUntil(memberId) - now);
+    }
+
+    void recordDenial(int memberId, const string& facilityName, int64_t now) {
+        memberCounters.recordDenial(memberId, now, windowMs, lockoutMs);
+        facilityCounters.recordDenial(facilityKey(facilityName), now, windowMs, lockoutMs);
+    }
+
+    int facilityDenials(const string& facilityName, int64_t now) const {
+        return facilityCounters.denialsInWindow(facilityKey(facilityName), now, windowMs);
+    }
+
+    vector<pair<int, int64_t>> lockedBadges(int64_t now) const {
+        vector<pair<int, int64_t>> result;
+        memberCounters.forEach([&](int64_t key, int64_t until, const vector<int64_t>&) {
+            if (until > now) result.emplace_back(static_cast<int>(key), until - now);
+        });
+        sort(result.begin(), result.end());
+        return result;
+    }
+
+    void clear() {
+        memberCounters.clear();
+        facilityCounters.clear();
+    }
+
+    // Меняет параметры, сохраняя действующие блокировки и недавние отказы.
+    // Новое окно и длительность относятся к следующим отказам; при смене
+    // порога отметки переносятся в таблицы с кольцом нового размера.
+    void reconfigure(int denialThreshold, int windowSeconds, int lockoutSeconds) {
+        if (windowSeconds <= 0 || lockoutSeconds <= 0) throw DataValidationError("Интервалы блокировки должны быть положительными");
+        if (denialThreshold != threshold) {
+            DenialCounterTable members(1024, denialThreshold);
+            DenialCounterTable facilities(256, denialThreshold);
+            memberCounters.forEach([&](int64_t key, int64_t until, const vector<int64_t>& stamps) {
+                members.restore(key, until, stamps);
+            });
+            facilityCounters.forEach([&](int64_t key, int64_t until, const vector<int64_t>& stamps) {
+                facilities.restore(key, until, stamps);
+            });
+            memberCounters = move(members);
+            facilityCounters = move(facilities);
+            threshold = denialThreshold;
+        }
+        windowMs = windowSeconds * 1000LL;
+        lockoutMs = lockoutSeconds * 1000LL;
+    }
+
+    void save(ofstream& file, int64_t now) const {
+        vector<string> lines;
+        memberCounters.forEach([&](int64_t key, int64_t until, const vector<int64_t>& stamps) {
+            vector<int64_t> recent;
+            for (int64_t stamp : stamps) {
+                if (now - stamp <= windowMs) recent.push_back(stamp);
+            }
+            if (until <= now && recent.empty()) return;
+            string line = to_string(key) + " " + to_string(until) + " " + to_string(recent.size());
+            for (int64_t stamp : recent) line += " " + to_string(stamp);
+            lines.push_back(line);
+        });
+        file << lines.size() << "\n";
+        for (const auto& line : lines) file << line << "\n";
+    }
+
+    void load(ifstream& file) {
+        clear();
+        size_t count;
+        file >> count;
+        for (size_t i = 0; i < count; ++i) {
+            int64_t key, until;
+            size_t stampCount;
+            file >> key >> until >> stampCount;
+            vector<int64_t> stamps(stampCount);
+            for (auto& stamp : stamps) file >> stamp;
+            if (!file) throw runtime_error("Некорректные данные блокировок");
+            memberCounters.restore(key, until, stamps);
+        }
+        file.ignore();
+    }
+};
+
+// Столбцовое хранилище решений о доступе. События копятся в открытом блоке и
+// запечатываются по 4096 штук или на границе часа: отметки времени кодируются
+// разностями второго порядка (zigzag + varint), ID членов и объектов
+// упаковываются в минимальное число бит относительно минимума блока. У каждого
+// блока есть min/max времени, поэтому запросы пропускают блоки вне окна.
+// Хранится не больше MAX_SEALED_BLOCKS блоков: самые старые вытесняются.
+// Открытые методы берут storeLock: проверки доступа из разных потоков
+// пишут в одно хранилище.
+class AccessEventStore {
+public:
+    static const size_t BLOCK_EVENTS = 4096;
+    static const size_t MAX_SEALED_BLOCKS = 4096;
+    static const int64_t PARTITION_MS = 3600 * 1000;
+    static const uint32_t UNKNOWN_FACILITY = 0;
+
+private:
+    class BitPacker {
+    public:
+        static int widthOf(uint32_t maxValue) {
+            return maxValue == 0 ? 0 : static_cast<int>(bit_width(maxValue));
+        }
+
+        static vector<uint64_t> pack(const vector<uint32_t>& values, int width) {
+            vector<uint64_t> words((values.size() * width + 63) / 64, 0);
+            size_t bit = 0;
+            for (uint32_t value : values) {
+                if (width == 0) break;
+                words[bit / 64] |= uint64_t(value) << (bit % 64);
+                if (bit % 64 + width > 64) words[bit / 64 + 1] |= uint64_t(value) >> (64 - bit % 64);
+                bit += width;
+            }
+            return words;
+        }
+
+        static uint32_t unpack(const vector<uint64_t>& words, int width, size_t index) {
+            if (width == 0) return 0;
+            size_t bit = index * width;
+            uint64_t value = words[bit / 64] >> (bit % 64);
+            if (bit % 64 + width > 64) value |= words[bit / 64 + 1] << (64 - bit % 64);
+            return static_cast<uint32_t>(value & ((uint64_t(1) << width) - 1));
+        }
+    };
+
+    struct SealedBlock {
+        int64_t minTime;
+        int64_t maxTime;
+        uint32_t count;
+        int64_t firstTime;
+        vector<uint8_t> timeDeltas;
+        int32_t memberBase;
+        int memberWidth;
+        vector<uint64_t> memberBits;
+        uint32_t facilityBase;
+        int facilityWidth;
+        vector<uint64_t> facilityBits;
+        vector<uint64_t> decisionBits;
+    };
+
+    deque<SealedBlock> blocks;
+    vector<int64_t> openTimes;
+    vector<int32_t> openMembers;
+    vector<uint32_t> openFacilities;
+    vector<uint8_t> openDecisions;
+    unordered_map<string, uint32_t> facilityIds;
+    vector<string> facilityNames;
+    mutable mutex storeLock;
+
+    static void writeVarint(vector<uint8_t>& out, int64_t value) {
+        uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        while (zigzag >= 0x80) {
+            out.push_back(static_cast<uint8_t>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(zigzag));
+    }
+
+    static int64_t readVarint(const uint8_t*& cursor) {
+        uint64_t zigzag = 0;
+        int shift = 0;
+        while (*cursor & 0x80) {
+            zigzag |= uint64_t(*cursor++ & 0x7F) << shift;
+            shift += 7;
+        }
+        zigzag |= uint64_t(*cursor++) << shift;
+        return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+    }
+
+    void seal() {
+        if (openTimes.empty()) return;
+        SealedBlock block;
+        block.count = static_cast<uint32_t>(openTimes.size());
+        block.minTime = *min_element(openTimes.begin(), openTimes.end());
+        block.maxTime = *max_element(openTimes.begin(), openTimes.end());
+        block.firstTime = openTimes[0];
+
+        int64_t previousDelta = 0;
+        for (size_t i = 1; i < openTimes.size(); ++i) {
+            int64_t delta = openTimes[i] - openTimes[i - 1];
+            writeVarint(block.timeDeltas, delta - previousDelta);
+            previousDelta = delta;
+        }
+        block.timeDeltas.shrink_to_fit();
+
+        auto memberRange = minmax_element(openMembers.begin(), openMembers.end());
+        block.memberBase = *memberRange.first;
+        vector<uint32_t> offsets(openMembers.size());
+        for (size_t i = 0; i < openMembers.size(); ++i) {
+            offsets[i] = static_cast<uint32_t>(int64_t(openMembers[i]) - block.memberBase);
+        }
+        block.memberWidth = BitPacker::widthOf(static_cast<uint32_t>(int64_t(*memberRange.second) - block.memberBase));
+        block.memberBits = BitPacker::pack(offsets, block.memberWidth);
+
+        auto facilityRange = minmax_element(openFacilities.begin(), openFacilities.end());
+        block.facilityBase = *facilityRange.first;
+        for (size_t i = 0; i < openFacilities.size(); ++i) offsets[i] = openFacilities[i] - block.facilityBase;
+        block.facilityWidth = BitPacker::widthOf(*facilityRange.second - block.facilityBase);
+        block.facilityBits = BitPacker::pack(offsets, block.facilityWidth);
+
+        for (size_t i = 0; i < openDecisions.size(); ++i) offsets[i] = openDecisions[i];
+        block.decisionBits = BitPacker::pack(offsets, 3);
+
+        blocks.push_back(move(block));
+        while (blocks.size() > MAX_SEALED_BLOCKS) blocks.pop_front();
+        openTimes.clear();
+        openMembers.clear();
+        openFacilities.clear();
+        openDecisions.clear();
     }
 
-    void save(ofstream& file) const override {
-        UniversityMember::save(file);
-        file << jobTitle << "\n";
+    template<typename Visitor>
+    void scan(int64_t fromMs, int64_t toMs, unsigned decisionMask, Visitor visit) const {
+        for (const auto& block : blocks) {
+            if (block.maxTime < fromMs || block.minTime >= toMs) continue;
+            const uint8_t* cursor = block.timeDeltas.data();
+            int64_t time = block.firstTime;
+            int64_t delta = 0;
+            for (uint32_t i = 0; i < block.count; ++i) {
+                if (i > 0) {
+                    delta += readVarint(cursor);
+                    time += delta;
+                }
+                if (time < fromMs || time >= toMs) continue;
+                uint32_t decision = BitPacker::unpack(block.decisionBits, 3, i);
+                if (!(decisionMask & (1u << decision))) continue;
+                visit(time, static_cast<int32_t>(block.memberBase + int64_t(BitPacker::unpack(block.memberBits, block.memberWidth, i))),
+                    block.facilityBase + BitPacker::unpack(block.facilityBits, block.facilityWidth, i));
+            }
+        }
+        for (size_t i = 0; i < openTimes.size(); ++i) {
+            if (openTimes[i] < fromMs || openTimes[i] >= toMs) continue;
+            if (!(decisionMask & (1u << openDecisions[i]))) continue;
+            visit(openTimes[i], openMembers[i], openFacilities[i]);
+        }
     }
 
-    void load(ifstream& file) override {
-        UniversityMember::load(file);
-        getline(file, jobTitle);
-        if (jobTitle.empty()) throw DataValidationError("Должность обязательна");
+public:
+    AccessEventStore() {
+        facilityId("(неизвестный объект)");
     }
-};
 
-class CampusFacility {
-private:
-    string facilityName;
-    int minAccessLevel;
+    static unsigned maskOf(AccessDecision decision) {
+        return 1u << static_cast<unsigned>(decision);
+    }
 
-public:
-    CampusFacility(const string& name, int level)
-        : facilityName(name), minAccessLevel(level) {
-        if (facilityName.empty()) throw DataValidationError("Название обязательно");
-        if (level < 1 || level > 3) throw DataValidationError("Уровень доступа от 1 до 3");
+    uint32_t facilityId(const string& facilityName) {
+        lock_guard<mutex> lock(storeLock);
+        auto it = facilityIds.find(facilityName);
+        if (it != facilityIds.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(facilityNames.size());
+        facilityIds.emplace(facilityName, id);
+        facilityNames.push_back(facilityName);
+        return id;
     }
 
-    string getFacilityName() const { return facilityName; }
-    int getMinAccessLevel() const { return minAccessLevel; }
+    string facilityName(uint32_t id) const {
+        lock_guard<mutex> lock(storeLock);
+        return facilityNames[id];
+    }
 
-    void setFacilityName(const string& name) {
-        if (name.empty()) throw DataValidationError("Название обязательно");
-        facilityName = name;
+    void record(int64_t timeMs, int memberId, uint32_t facility, AccessDecision decision) {
+        lock_guard<mutex> lock(storeLock);
+        if (!openTimes.empty() && (openTimes.size() == BLOCK_EVENTS ||
+            timeMs / PARTITION_MS != openTimes.front() / PARTITION_MS)) {
+            seal();
+        }
+        openTimes.push_back(timeMs);
+        openMembers.push_back(memberId);
+        openFacilities.push_back(facility);
+        openDecisions.push_back(static_cast<uint8_t>(decision));
     }
 
-    void setMinAccessLevel(int level) {
-        if (level < 1 || level > 3) throw DataValidationError("Уровень доступа от 1 до 3");
-        minAccessLevel = level;
+    size_t eventCount() const {
+        lock_guard<mutex> lock(storeLock);
+        size_t total = openTimes.size();
+        for (const auto& block : blocks) total += block.count;
+        return total;
     }
 
-    void showInfo() const {
-        cout << "Объект: " << facilityName
-            << ", Минимальный уровень доступа: " << minAccessLevel << endl;
+    size_t blockCount() const {
+        lock_guard<mutex> lock(storeLock);
+        return blocks.size();
     }
 
-    bool verifyAccess(const UniversityMember& member) const {
-        return member.getClearanceLevel() >= minAccessLevel;
+    size_t compressedBytes() const {
+        lock_guard<mutex> lock(storeLock);
+        size_t total = 0;
+        for (const auto& block : blocks) {
+            total += sizeof(SealedBlock) + block.timeDeltas.size() +
+                (block.memberBits.size() + block.facilityBits.size() + block.decisionBits.size()) * sizeof(uint64_t);
+        }
+        return total;
     }
 
-    void save(ofstream& file) const {
-        file << facilityName << "\n" << minAccessLevel << "\n";
+    // Число событий по (объект, начало интервала bucketMs) в окне [fromMs, toMs).
+    map<pair<uint32_t, int64_t>, uint64_t> countByFacility(int64_t fromMs, int64_t toMs,
+        int64_t bucketMs, unsigned decisionMask) const {
+        lock_guard<mutex> lock(storeLock);
+        map<pair<uint32_t, int64_t>, uint64_t> counts;
+        scan(fromMs, toMs, decisionMask, [&](int64_t time, int32_t, uint32_t facility) {
+            ++counts[{ facility, time - time % bucketMs }];
+        });
+        return counts;
     }
 
-    void load(ifstream& file) {
-        getline(file, facilityName);
-        file >> minAccessLevel;
-        file.ignore();
-        if (facilityName.empty()) throw DataValidationError("Название обязательно");
-        if (minAccessLevel < 1 || minAccessLevel > 3)
-            throw DataValidationError("Уровень доступа от 1 до 3");
+    map<uint32_t, size_t> distinctMembersByFacility(int64_t fromMs, int64_t toMs, unsigned decisionMask) const {
+        map<uint32_t, vector<int32_t>> seen;
+        unique_lock<mutex> lock(storeLock);
+        scan(fromMs, toMs, decisionMask, [&](int64_t, int32_t member, uint32_t facility) {
+            seen[facility].push_back(member);
+        });
+        lock.unlock();
+        map<uint32_t, size_t> result;
+        for (auto& entry : seen) {
+            sort(entry.second.begin(), entry.second.end());
+            result[entry.first] = static_cast<size_t>(
+                unique(entry.second.begin(), entry.second.end()) - entry.second.begin());
+        }
+        return result;
     }
 };
 
@@ -233,10 +1960,16 @@ class AccessManagementSystem {
 private:
     vector<unique_ptr<UniversityMember>> members;
     vector<T> facilities;
+    mutable AccessStatistics statistics;
+    mutable MemberColumns columns;
+    mutable bool columnsStale = true;
+    unique_ptr<DenialLockout> lockout = make_unique<DenialLockout>();
+    mutable AccessEventStore events;
 
 public:
     void addMember(unique_ptr<UniversityMember> member) {
-        members.push_back()move(member);
+        members.push_back(move(member));
+        columnsStale = true;
     }
 
     void addFacility(const T& facility) {
@@ -255,30 +1988,112 @@ public:
         }
     }
 
-    bool verifyMemberAccess(int memberId, const string& facilityName) const {
+    AccessDecision checkAccess(int memberId, const string& facilityName,
+        const UniversityMember** foundMember = nullptr, NameMatch match = NameMatch::Exact) const {
+        ScopedLatency timer(statistics.histogram(AccessOperation::VerifyAccess));
+        int64_t now = DenialLockout::nowMs();
+        const T* facility = nullptr;
+        AccessDecision decision = decideAccess(memberId, facilityName, foundMember, &facility, match, now);
+        // В журнал попадает найденный объект, а не строка запроса: при NameMatch::IgnoreCase
+        // разные написания одного объекта не должны давать разные строки отчета, а
+        // несуществующие имена не должны копиться в словаре объектов. Заблокированному
+        // пропуску отказывают до поиска объекта, поэтому объект ищется уже после решения.
+        if (decision == AccessDecision::LockedOut) facility = findFacility(facilityName, match);
+        events.record(now, memberId,
+            facility ? events.facilityId(facility->getFacilityName()) : AccessEventStore::UNKNOWN_FACILITY, decision);
+        return decision;
+    }
+
+    const T* findFacility(const string& facilityName, NameMatch match) const {
+        auto facilityIt = facilities.end();
+        if (match == NameMatch::IgnoreCase) {
+            string folded = foldCaseUtf8(facilityName);
+            facilityIt = find_if(facilities.begin(), facilities.end(),
+                [&folded](const T& f) { return f.getFoldedName() == folded; });
+        }
+        else {
+            facilityIt = find_if(facilities.begin(), facilities.end(),
+                [&facilityName](const T& f) { return f.getFacilityName() == facilityName; });
+        }
+        return facilityIt == facilities.end() ? nullptr : &*facilityIt;
+    }
+
+    AccessDecision decideAccess(int memberId, const string& facilityName,
+        const UniversityMember** foundMember, const T** foundFacility, NameMatch match, int64_t now) const {
+        if (lockout->isLocked(memberId, now)) {
+            statistics.lockedOut.increment();
+            return AccessDecision::LockedOut;
+        }
+
         auto memberIt = find_if(members.begin(), members.end(),
             [memberId](const auto& m) { return m->getMemberId() == memberId; });
-
-        auto facilityIt = find_if(facilities.begin(), facilities.end(),
-            [facilityName](const T& f) { return f.getFacilityName() == facilityName; });
+        const T* facility = findFacility(facilityName, match);
+        *foundFacility = facility;
 
         if (memberIt == members.end()) {
-            throw runtime_error("Член университета с ID " + to_string(memberId) + " не найден");
+            statistics.unknown.increment();
+            return AccessDecision::UnknownMember;
         }
+        if (foundMember) *foundMember = memberIt->get();
 
-        if (facilityIt == facilities.end()) {
-            throw runtime_error("Объект " + facilityName + " не найден");
+        if (!facility) {
+            statistics.unknown.increment();
+            return AccessDecision::UnknownFacility;
+        }
+
+        if (!facility->verifyAccess(**memberIt)) {
+            statistics.denied.increment();
+            lockout->recordDenial(memberId, facility->getFacilityName(), now);
+            return AccessDecision::Denied;
         }
 
-        if (!facilityIt->verifyAccess(**memberIt)) {
-            throw AccessViolationError("Доступ запрещен для " + (*memberIt)->getFullName() +
+        statistics.allowed.increment();
+        return AccessDecision::Allowed;
+    }
+
+    bool verifyMemberAccess(int memberId, const string& facilityName, NameMatch match = NameMatch::Exact) const {
+        const UniversityMember* member = nullptr;
+        switch (checkAccess(memberId, facilityName, &member, match)) {
+        case AccessDecision::UnknownMember:
+            throw runtime_error("Член университета с ID " + to_string(memberId) + " не найден");
+        case AccessDecision::UnknownFacility:
+            throw runtime_error("Объект " + facilityName + " не найден");
+        case AccessDecision::Denied:
+            throw AccessViolationError("Доступ запрещен для " + member->getFullName() +
                 " к объекту " + facilityName);
+        case AccessDecision::LockedOut:
+            throw AccessViolationError("Пропуск ID " + to_string(memberId) + " временно заблокирован еще на " +
+                to_string(lockout->remainingMs(memberId, DenialLockout::nowMs()) / 1000) + " с");
+        default:
+            return true;
         }
+    }
 
-        return true;
+    const UniversityMember* lookupMember(int id) const {
+        for (const auto& member : members) {
+            if (member->getMemberId() == id) return member.get();
+        }
+        return nullptr;
+    }
+
+    vector<const UniversityMember*> collectMembersByName(const string& name) const {
+        vector<const UniversityMember*> result;
+        for (const auto& member : members) {
+            if (member->getFullName() == name) result.push_back(member.get());
+        }
+        return result;
+    }
+
+    vector<const UniversityMember*> collectAllMembers() const {
+        vector<const UniversityMember*> result;
+        for (const auto& member : members) result.push_back(member.get());
+        return result;
     }
 
+    size_t memberCount() const { return members.size(); }
+
     void saveData(const string& filename) const {
+        ScopedLatency timer(statistics.histogram(AccessOperation::SaveData));
         ofstream file(filename);
         if (!file) throw runtime_error("Ошибка открытия файла");
 
@@ -291,14 +2106,19 @@ public:
         for (const auto& facility : facilities) {
             facility.save(file);
         }
+
+        file << "lockouts\n";
+        lockout->save(file, DenialLockout::nowMs());
     }
 
     void loadData(const string& filename) {
+        ScopedLatency timer(statistics.histogram(AccessOperation::LoadData));
         ifstream file(filename);
         if (!file) throw runtime_error("Ошибка открытия файла");
 
         members.clear();
         facilities.clear();
+        columnsStale = true;
 
         int memberCount;
         file >> memberCount;
@@ -335,12 +2155,67 @@ public:
             facility.load(file);
             facilities.push_back(facility);
         }
+
+        lockout->clear();
+        string section;
+        if (getline(file, section) && section == "lockouts") {
+            lockout->load(file);
+        }
+    }
+
+    void configureLockout(int threshold, int windowSeconds, int lockoutSeconds) {
+        lockout->reconfigure(threshold, windowSeconds, lockoutSeconds);
+    }
+
+    void showLockouts() const {
+        int64_t now = DenialLockout::nowMs();
+        cout << "Порог: " << lockout->getThreshold() << " отказов за " << lockout->getWindowMs() / 1000
+            << " с, блокировка на " << lockout->getLockoutMs() / 1000 << " с\n";
+
+        auto locked = lockout->lockedBadges(now);
+        if (locked.empty()) cout << "Заблокированных пропусков нет\n";
+        for (const auto& badge : locked) {
+            cout << "ID " << badge.first << ": осталось " << badge.second / 1000 << " с\n";
+        }
+        for (const auto& facility : facilities) {
+            int denials = lockout->facilityDenials(facility.getFacilityName(), now);
+            if (denials > 0) cout << facility.getFacilityName() << ": отказов в окне " << denials << "\n";
+        }
+    }
+
+    void showDenialReport(int hours) const {
+        int64_t now = DenialLockout::nowMs();
+        int64_t from = now - hours * AccessEventStore::PARTITION_MS;
+        unsigned refused = AccessEventStore::maskOf(AccessDecision::Denied) |
+            AccessEventStore::maskOf(AccessDecision::LockedOut);
+
+        auto counts = events.countByFacility(from, now + 1, AccessEventStore::PARTITION_MS, refused);
+        auto distinct = events.distinctMembersByFacility(from, now + 1, refused);
+        if (counts.empty()) cout << "Отказов за период нет\n";
+        for (const auto& entry : counts) {
+            time_t hourStart = static_cast<time_t>(entry.first.second / 1000);
+            char label[32];
+            strftime(label, sizeof(label), "%Y-%m-%d %H:00", localtime(&hourStart));
+            cout << events.facilityName(entry.first.first) << ", " << label << ": " << entry.second << "\n";
+        }
+        for (const auto& entry : distinct) {
+            cout << events.facilityName(entry.first) << ": разных пропусков с отказом " << entry.second << "\n";
+        }
+        cout << "Событий в журнале: " << events.eventCount() << ", блоков: " << events.blockCount() << endl;
+    }
+
+    bool isBadgeLocked(int memberId) const {
+        return lockout->isLocked(memberId, DenialLockout::nowMs());
     }
 
-    void findMemberByName(const string& name) const {
+    void findMemberByName(const string& name, NameMatch match = NameMatch::Exact) const {
+        ScopedLatency timer(statistics.histogram(AccessOperation::FindByName));
         bool found = false;
+        string folded = match == NameMatch::IgnoreCase ? foldCaseUtf8(name) : string();
         for (const auto& member : members) {
-            if (member->getFullName() == name) {
+            bool matches = match == NameMatch::IgnoreCase ? member->getFoldedName() == folded
+                : member->getFullName() == name;
+            if (matches) {
                 member->showDetails();
                 found = true;
             }
@@ -351,6 +2226,7 @@ public:
     }
 
     void findMemberById(int id) const {
+        ScopedLatency timer(statistics.histogram(AccessOperation::FindById));
         bool found = false;
         for (const auto& member : members) {
             if (member->getMemberId() == id) {
@@ -365,6 +2241,8 @@ public:
     }
 
     void sortMembersByAccessLevel() {
+        ScopedLatency timer(statistics.histogram(AccessOperation::SortByLevel));
+        columnsStale = true;
         sort(members.begin(), members.end(),
             [](const auto& a, const auto& b) {
                 return a->getClearanceLevel() < b->getClearanceLevel();
@@ -372,13 +2250,414 @@ public:
     }
 
     void sortMembersByName() {
+        ScopedLatency timer(statistics.histogram(AccessOperation::SortByName));
+        columnsStale = true;
         sort(members.begin(), members.end(),
             [](const auto& a, const auto& b) {
                 return a->getFullName() < b->getFullName();
             });
     }
+
+    vector<const UniversityMember*> queryMembers(const MemberFilter& filter, ostream* planOutput = nullptr) const {
+        ScopedLatency timer(statistics.histogram(AccessOperation::QueryMembers));
+        if (columnsStale) {
+            columns.rebuild(members);
+            columnsStale = false;
+        }
+
+        MemberQueryPlan plan(filter, columns);
+        if (planOutput) {
+            plan.describe(*planOutput);
+            *planOutput << "\n";
+        }
+
+        vector<const UniversityMember*> result;
+        plan.execute(columns).forEach([&](size_t row) { result.push_back(members[row].get()); });
+        return result;
+    }
+
+    void showStatistics() const {
+        uint64_t allowedCount = statistics.allowed.total();
+        uint64_t deniedCount = statistics.denied.total();
+        uint64_t unknownCount = statistics.unknown.total();
+        uint64_t lockedOutCount = statistics.lockedOut.total();
+        uint64_t checks = allowedCount + deniedCount + unknownCount + lockedOutCount;
+        auto share = [checks](uint64_t value) {
+            return checks == 0 ? 0.0 : 100.0 * value / checks;
+        };
+
+        cout << "Операция: количество, p50/p90/p99/max (мкс)\n";
+        for (int i = 0; i < static_cast<int>(AccessOperation::Count); ++i) {
+            auto operation = static_cast<AccessOperation>(i);
+            auto summary = statistics.histogram(operation).summarize();
+            cout << operationName(operation) << ": " << summary.count << ", "
+                << summary.p50 / 1000.0 << "/" << summary.p90 / 1000.0 << "/"
+                << summary.p99 / 1000.0 << "/" << summary.max / 1000.0 << "\n";
+        }
+        cout << "Проверок доступа: " << checks
+            << ", разрешено: " << allowedCount << " (" << share(allowedCount) << "%)"
+            << ", отказано: " << deniedCount << " (" << share(deniedCount) << "%)"
+            << ", не найдено: " << unknownCount << " (" << share(unknownCount) << "%)"
+            << ", заблокировано: " << lockedOutCount << " (" << share(lockedOutCount) << "%)\n";
+        cout << "Членов: " << members.size() << ", объектов: " << facilities.size() << endl;
+    }
+
+    // Формат "ключ значение" по строке на метрику, удобный для периодического сбора.
+    void dumpStatistics(ostream& out) const {
+        for (int i = 0; i < static_cast<int>(AccessOperation::Count); ++i) {
+            auto operation = static_cast<AccessOperation>(i);
+            auto summary = statistics.histogram(operation).summarize();
+            string prefix = string("access_") + operationName(operation);
+            out << prefix << "_count " << summary.count << "\n"
+                << prefix << "_p50_ns " << summary.p50 << "\n"
+                << prefix << "_p90_ns " << summary.p90 << "\n"
+                << prefix << "_p99_ns " << summary.p99 << "\n"
+                << prefix << "_max_ns " << summary.max << "\n";
+        }
+        out << "access_allowed_total " << statistics.allowed.total() << "\n"
+            << "access_denied_total " << statistics.denied.total() << "\n"
+            << "access_unknown_total " << statistics.unknown.total() << "\n"
+            << "access_locked_out_total " << statistics.lockedOut.total() << "\n"
+            << "lockout_badges_locked " << lockout->lockedBadges(DenialLockout::nowMs()).size() << "\n"
+            << "index_members_size " << members.size() << "\n"
+            << "index_facilities_size " << facilities.size() << "\n"
+            << "index_member_columns_size " << (columnsStale ? 0 : columns.rows()) << "\n";
+    }
+
+    void resetStatistics() {
+        statistics.reset();
+    }
+
+    uint64_t publishReplica(SharedReplicaWriter& writer) const {
+        return writer.publish(members, facilities);
+    }
+};
+
+// Члены распределяются по шардам по хешу ID, у каждого шарда свой рабочий
+// поток (по возможности закреплённый за ядром) и своя очередь задач.
+// Объекты кампуса копируются во все шарды, поэтому проверка доступа целиком
+// выполняется в шарде члена университета.
+template<typename T>
+class ShardedAccessSystem {
+private:
+    struct Shard {
+        AccessManagementSystem<T> system;
+        thread worker;
+        mutex queueLock;
+        condition_variable queueReady;
+        deque<function<void()>> tasks;
+        bool stopping = false;
+    };
+    vector<unique_ptr<Shard>> shards;
+
+    static void runWorker(Shard& shard) {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(shard.queueLock);
+                shard.queueReady.wait(lock, [&shard] { return shard.stopping || !shard.tasks.empty(); });
+                if (shard.tasks.empty()) return;
+                task = move(shard.tasks.front());
+                shard.tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    static void pinToCore(thread& worker, size_t core) {
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core % max(1u, thread::hardware_concurrency()), &cpus);
+        pthread_setaffinity_np(worker.native_handle(), sizeof(cpus), &cpus);
+#else
+        (void)worker;
+        (void)core;
+#endif
+    }
+
+    template<typename F>
+    auto submit(size_t index, F task) -> future<decltype(task(declval<AccessManagementSystem<T>&>()))> {
+        using Result = decltype(task(declval<AccessManagementSystem<T>&>()));
+        Shard& shard = *shards[index];
+        auto packaged = make_shared<packaged_task<Result()>>(
+            [&shard, task]() mutable { return task(shard.system); });
+        future<Result> result = packaged->get_future();
+        {
+            lock_guard<mutex> lock(shard.queueLock);
+            shard.tasks.emplace_back([packaged] { (*packaged)(); });
+        }
+        shard.queueReady.notify_one();
+        return result;
+    }
+
+    template<typename F>
+    auto scatter(F task) -> vector<decltype(task(declval<AccessManagementSystem<T>&>()))> {
+        using Result = decltype(task(declval<AccessManagementSystem<T>&>()));
+        vector<future<Result>> pending;
+        for (size_t i = 0; i < shards.size(); ++i) pending.push_back(submit(i, task));
+        vector<Result> gathered;
+        for (auto& f : pending) gathered.push_back(f.get());
+        return gathered;
+    }
+
+public:
+    explicit ShardedAccessSystem(size_t shardCount) {
+        if (shardCount == 0) throw DataValidationError("Нужен хотя бы один шард");
+        for (size_t i = 0; i < shardCount; ++i) {
+            shards.push_back(make_unique<Shard>());
+            Shard& shard = *shards.back();
+            shard.worker = thread([&shard] { runWorker(shard); });
+            pinToCore(shard.worker, i);
+        }
+    }
+
+    ShardedAccessSystem(const ShardedAccessSystem&) = delete;
+    ShardedAccessSystem& operator=(const ShardedAccessSystem&) = delete;
+
+    ~ShardedAccessSystem() {
+        for (auto& shard : shards) {
+            {
+                lock_guard<mutex> lock(shard->queueLock);
+                shard->stopping = true;
+            }
+            shard->queueReady.notify_one();
+        }
+        for (auto& shard : shards) shard->worker.join();
+    }
+
+    size_t shardCount() const { return shards.size(); }
+
+    size_t shardOf(int memberId) const {
+        uint64_t mixed = static_cast<uint64_t>(static_cast<uint32_t>(memberId)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>((mixed >> 32) % shards.size());
+    }
+
+    void addMember(unique_ptr<UniversityMember> member) {
+        size_t index = shardOf(member->getMemberId());
+        auto shared = make_shared<unique_ptr<UniversityMember>>(move(member));
+        submit(index, [shared](AccessManagementSystem<T>& system) {
+            system.addMember(move(*shared));
+            return true;
+        }).get();
+    }
+
+    void addFacility(const T& facility) {
+        scatter([facility](AccessManagementSystem<T>& system) {
+            system.addFacility(facility);
+            return true;
+        });
+    }
+
+    bool verifyMemberAccess(int memberId, const string& facilityName) {
+        return submit(shardOf(memberId), [memberId, facilityName](AccessManagementSystem<T>& system) {
+            return system.verifyMemberAccess(memberId, facilityName);
+        }).get();
+    }
+
+    // Пакетная проверка: запросы группируются по шардам, каждый шард получает
+    // одну задачу на свою часть пакета. Возвращает число разрешённых проходов.
+    size_t countAllowed(const vector<int>& memberIds, const string& facilityName) {
+        vector<vector<int>> routed(shards.size());
+        for (int id : memberIds) routed[shardOf(id)].push_back(id);
+
+        vector<future<size_t>> pending;
+        for (size_t i = 0; i < shards.size(); ++i) {
+            auto ids = make_shared<vector<int>>(move(routed[i]));
+            pending.push_back(submit(i, [ids, facilityName](AccessManagementSystem<T>& system) {
+                size_t allowed = 0;
+                for (int id : *ids) {
+                    if (system.checkAccess(id, facilityName) == AccessDecision::Allowed) ++allowed;
+                }
+                return allowed;
+            }));
+        }
+
+        size_t total = 0;
+        for (auto& f : pending) total += f.get();
+        return total;
+    }
+
+    // Возвращённые указатели принадлежат шардам и действительны, пока жива
+    // система. Через ShardedAccessSystem члены только добавляются: объекты не
+    // удаляются и не меняются, а перестройка вектора шарда переносит лишь
+    // unique_ptr, поэтому читать член из вызывающего потока безопасно.
+    const UniversityMember* findMemberById(int id) {
+        return submit(shardOf(id), [id](AccessManagementSystem<T>& system) {
+            return system.lookupMember(id);
+        }).get();
+    }
+
+    vector<const UniversityMember*> findMembersByName(const string& name) {
+        vector<const UniversityMember*> merged;
+        for (auto& part : scatter([name](AccessManagementSystem<T>& system) {
+            return system.collectMembersByName(name);
+        })) {
+            merged.insert(merged.end(), part.begin(), part.end());
+        }
+        return merged;
+    }
+
+    // Каждый шард параллельно сортирует копию указателей на свои члены
+    // (данные шарда не переставляются), затем списки сливаются.
+    vector<const UniversityMember*> listMembersSortedByName() {
+        return listSorted([](const UniversityMember* a, const UniversityMember* b) {
+            return a->getFullName() < b->getFullName();
+        });
+    }
+
+    vector<const UniversityMember*> listMembersSortedByAccessLevel() {
+        return listSorted([](const UniversityMember* a, const UniversityMember* b) {
+            return a->getClearanceLevel() < b->getClearanceLevel();
+        });
+    }
+
+private:
+    template<typename Less>
+    vector<const UniversityMember*> listSorted(Less less) {
+        auto parts = scatter([less](AccessManagementSystem<T>& system) {
+            vector<const UniversityMember*> part = system.collectAllMembers();
+            sort(part.begin(), part.end(), less);
+            return part;
+        });
+        return mergeSorted(parts, less);
+    }
+
+    template<typename Less>
+    static vector<const UniversityMember*> mergeSorted(vector<vector<const UniversityMember*>>& parts, Less less) {
+        vector<const UniversityMember*> merged;
+        for (auto& part : parts) {
+            size_t middle = merged.size();
+            merged.insert(merged.end(), part.begin(), part.end());
+            inplace_merge(merged.begin(), merged.begin() + middle, merged.end(), less);
+        }
+        return merged;
+    }
 };
 
+// Слабое масштабирование: на каждый шард приходится одинаковое число членов
+// и запросов, поэтому рост пропускной способности показывает вклад ядер.
+void runShardBenchmark() {
+    const int membersPerShard = 2000;
+    const size_t checksPerShard = 20000;
+    size_t maxShards = max(1u, thread::hardware_concurrency());
+
+    cout << "Шардов | проверок/с | ускорение\n";
+    double baseline = 0;
+    for (size_t shardCount = 1; shardCount <= maxShards; shardCount *= 2) {
+        ShardedAccessSystem<CampusFacility> sharded(shardCount);
+        sharded.addFacility(CampusFacility("Лаборатория", 2));
+
+        int total = static_cast<int>(membersPerShard * shardCount);
+        for (int id = 1; id <= total; ++id) {
+            sharded.addMember(make_unique<Professor>("Преподаватель " + to_string(id), id, "Кафедра"));
+        }
+
+        vector<int> ids;
+        mt19937 random(42);
+        uniform_int_distribution<int> pick(1, total);
+        for (size_t i = 0; i < checksPerShard * shardCount; ++i) ids.push_back(pick(random));
+
+        auto started = chrono::steady_clock::now();
+        size_t allowed = sharded.countAllowed(ids, "Лаборатория");
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        double throughput = ids.size() / seconds;
+        if (baseline == 0) baseline = throughput;
+
+        cout << shardCount << " | " << static_cast<uint64_t>(throughput) << " | "
+            << throughput / baseline << (allowed == ids.size() ? "" : " (ошибка проверки)") << "\n";
+    }
+}
+
+void runEventStoreBenchmark() {
+    const size_t eventCount = 5000000;
+    const int64_t start = DenialLockout::nowMs() - 30LL * 24 * AccessEventStore::PARTITION_MS;
+    AccessEventStore store;
+    vector<uint32_t> facilityIds;
+    for (int i = 0; i < 32; ++i) facilityIds.push_back(store.facilityId("Объект " + to_string(i)));
+
+    mt19937 random(7);
+    vector<int32_t> members(eventCount);
+    vector<uint8_t> facilities(eventCount);
+    for (size_t i = 0; i < eventCount; ++i) {
+        members[i] = static_cast<int32_t>(1000 + random() % 50000);
+        facilities[i] = static_cast<uint8_t>(random() % facilityIds.size());
+    }
+
+    auto started = chrono::steady_clock::now();
+    int64_t time = start;
+    for (size_t i = 0; i < eventCount; ++i) {
+        time += 500 + (i % 7);
+        AccessDecision decision = (members[i] % 5 == 0) ? AccessDecision::Denied : AccessDecision::Allowed;
+        store.record(time, members[i], facilityIds[facilities[i]], decision);
+    }
+    double ingestSeconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    started = chrono::steady_clock::now();
+    auto counts = store.countByFacility(time - 24 * AccessEventStore::PARTITION_MS, time + 1,
+        AccessEventStore::PARTITION_MS, AccessEventStore::maskOf(AccessDecision::Denied));
+    auto distinct = store.distinctMembersByFacility(time - 24 * AccessEventStore::PARTITION_MS, time + 1,
+        AccessEventStore::maskOf(AccessDecision::Denied));
+    double querySeconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    size_t rawBytes = eventCount * (sizeof(int64_t) + sizeof(int32_t) + sizeof(uint32_t) + 1);
+    cout << "Запись: " << static_cast<uint64_t>(eventCount / ingestSeconds) << " событий/с\n";
+    cout << "Блоков: " << store.blockCount() << ", сжатие: " << rawBytes / 1024 << " КБ -> "
+        << store.compressedBytes() / 1024 << " КБ\n";
+    cout << "Запрос за сутки (" << counts.size() << " групп, " << distinct.size() << " объектов): "
+        << querySeconds * 1000 << " мс\n";
+}
+
+// Эталон для сравнения: декодирование в wchar_t, towlower и обратное кодирование.
+string foldCaseWithTowlower(const string& text) {
+    string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        unsigned char byte = static_cast<unsigned char>(text[i]);
+        wchar_t symbol = byte;
+        size_t width = 1;
+        if ((byte & 0xE0) == 0xC0 && i + 1 < text.size()) {
+            symbol = ((byte & 0x1F) << 6) | (static_cast<unsigned char>(text[i + 1]) & 0x3F);
+            width = 2;
+        }
+        wchar_t lower = static_cast<wchar_t>(towlower(static_cast<wint_t>(symbol)));
+        if (lower < 0x80) {
+            result += static_cast<char>(lower);
+        }
+        else {
+            result += static_cast<char>(0xC0 | (lower >> 6));
+            result += static_cast<char>(0x80 | (lower & 0x3F));
+        }
+        i += width;
+    }
+    return result;
+}
+
+void runCaseFoldBenchmark() {
+    setlocale(LC_CTYPE, "C.UTF-8");
+    const string samples[] = { "Серверная ", "СЕРВЕРНАЯ ", "Аудитория 101 ", "Лаборатория ", "Ёлкин Пётр ", "ИТ-101 " };
+    string text;
+    while (text.size() < (16u << 20)) {
+        for (const auto& sample : samples) text += sample;
+    }
+
+    auto measure = [&text](string (*fold)(const string&), string& output) {
+        auto started = chrono::steady_clock::now();
+        for (int i = 0; i < 5; ++i) output = fold(text);
+        return chrono::duration<double>(chrono::steady_clock::now() - started).count() / 5;
+    };
+
+    string simdResult, referenceResult;
+    double simdSeconds = measure(foldCaseUtf8, simdResult);
+    double referenceSeconds = measure(foldCaseWithTowlower, referenceResult);
+    double megabytes = text.size() / 1048576.0;
+
+    cout << "Ядро: " << megabytes / simdSeconds << " МБ/с\n";
+    cout << "towlower: " << megabytes / referenceSeconds << " МБ/с\n";
+    cout << "Ускорение: " << referenceSeconds / simdSeconds
+        << (simdResult == referenceResult ? "" : " (результаты различаются)") << "\n";
+}
+
 unique_ptr<UniversityMember> createUniversityMember() {
     cout << "Тип члена университета:\n";
     cout << "1. Студент\n2. Преподаватель\n3. Персонал\nВыбор: ";
@@ -446,6 +2725,9 @@ CampusFacility createCampusFacility() {
 }
 
 void displayMainMenu(AccessManagementSystem<CampusFacility>& system) {
+    unique_ptr<SharedReplicaWriter> replicaWriter;
+    NameMatch nameMatch = NameMatch::Exact;
+
     while (true) {
         cout << "\n=== Управление доступом ===\n";
         cout << "1. Добавить члена университета\n";
@@ -459,6 +2741,15 @@ void displayMainMenu(AccessManagementSystem<CampusFacility>& system) {
         cout << "9. Сортировать по ФИО\n";
         cout << "10. Сохранить данные\n";
         cout << "11. Загрузить данные\n";
+        cout << "12. Показать статистику\n";
+        cout << "13. Выгрузить статистику в файл\n";
+        cout << "14. Сбросить статистику\n";
+        cout << "15. Опубликовать реплику в разделяемой памяти\n";
+        cout << "16. Отчет по фильтру\n";
+        cout << "17. Заблокированные пропуска\n";
+        cout << "18. Настроить блокировку пропусков\n";
+        cout << "19. Отказы по объектам и часам\n";
+        cout << "20. Поиск без учета регистра: " << (nameMatch == NameMatch::IgnoreCase ? "вкл" : "выкл") << "\n";
         cout << "0. Выход\n";
         cout << "Выбор: ";
 
@@ -502,7 +2793,7 @@ void displayMainMenu(AccessManagementSystem<CampusFacility>& system) {
                 getline(cin, facility);
 
                 try {
-                    if (system.verifyMemberAccess(id, facility)) {
+                    if (system.verifyMemberAccess(id, facility, nameMatch)) {
                         cout << "Доступ разрешен\n";
                     }
                 }
@@ -518,7 +2809,7 @@ void displayMainMenu(AccessManagementSystem<CampusFacility>& system) {
                 string name;
                 cout << "ФИО: ";
                 getline(cin, name);
-                system.findMemberByName(name);
+                system.findMemberByName(name, nameMatch);
                 break;
             }
             case 7: {
@@ -553,7 +2844,92 @@ void displayMainMenu(AccessManagementSystem<CampusFacility>& system) {
                 cout << "Загружено\n";
                 break;
             }
+            case 12:
+                system.showStatistics();
+                break;
+            case 13: {
+                string filename;
+                cout << "Файл: ";
+                getline(cin, filename);
+                ofstream file(filename);
+                if (!file) throw runtime_error("Ошибка открытия файла");
+                system.dumpStatistics(file);
+                cout << "Выгружено\n";
+                break;
+            }
+            case 14:
+                system.resetStatistics();
+                cout << "Статистика сброшена\n";
+                break;
+            case 15: {
+                if (!replicaWriter) {
+                    string segmentName;
+                    cout << "Имя сегмента (например, /access_replica): ";
+                    getline(cin, segmentName);
+                    replicaWriter = make_unique<SharedReplicaWriter>(segmentName);
+                }
+                cout << "Опубликовано поколение " << system.publishReplica(*replicaWriter) << "\n";
+                break;
+            }
+            case 16: {
+                int type, level, idFrom, idTo;
+                string affiliation;
+                cout << "Тип (0 - любой, 1 - студент, 2 - преподаватель, 3 - персонал): ";
+                cin >> type;
+                cout << "Уровень доступа (0 - любой): ";
+                cin >> level;
+                cin.ignore();
+                cout << "Группа/кафедра/должность (пусто - любая): ";
+                getline(cin, affiliation);
+                cout << "ID от: ";
+                cin >> idFrom;
+                cout << "ID до: ";
+                cin >> idTo;
+                cin.ignore();
+
+                MemberFilter filter = MemberFilter::where(MemberField::Id, CompareOp::GreaterEqual, idFrom) &&
+                    MemberFilter::where(MemberField::Id, CompareOp::LessEqual, idTo);
+                if (type != 0) filter = filter && MemberFilter::where(MemberField::Kind, CompareOp::Equal, type);
+                if (level != 0) filter = filter && MemberFilter::where(MemberField::ClearanceLevel, CompareOp::Equal, level);
+                if (!affiliation.empty()) {
+                    filter = filter && MemberFilter::where(MemberField::Affiliation, CompareOp::Equal, affiliation);
+                }
+
+                cout << "План: ";
+                auto found = system.queryMembers(filter, &cout);
+                for (const auto* member : found) member->showDetails();
+                cout << "Найдено: " << found.size() << "\n";
+                break;
+            }
+            case 17:
+                system.showLockouts();
+                break;
+            case 18: {
+                int threshold, windowSeconds, lockoutSeconds;
+                cout << "Отказов до блокировки: ";
+                cin >> threshold;
+                cout << "Окно (с): ";
+                cin >> windowSeconds;
+                cout << "Длительность блокировки (с): ";
+                cin >> lockoutSeconds;
+                cin.ignore();
+                system.configureLockout(threshold, windowSeconds, lockoutSeconds);
+                cout << "Настроено\n";
+                break;
+            }
+            case 19: {
+                int hours;
+                cout << "За сколько часов: ";
+                cin >> hours;
+                cin.ignore();
+                system.showDenialReport(hours);
+                break;
+            }
+            case 20:
+                nameMatch = nameMatch == NameMatch::Exact ? NameMatch::IgnoreCase : NameMatch::Exact;
+                break;
             case 0:
+                if (replicaWriter) replicaWriter->unlink();
                 return;
             default:
                 cout << "Неверный выбор\n";
@@ -565,9 +2941,75 @@ void displayMainMenu(AccessManagementSystem<CampusFacility>& system) {
     }
 }
 
-int main() {
+void runReplicaReader(const string& segmentName) {
+    SharedReplicaReader replica(segmentName);
+    cout << "Реплика " << segmentName << ", поколение " << replica.generation() << "\n";
+
+    while (true) {
+        int id;
+        cout << "ID члена (0 - выход): ";
+        if (!(cin >> id) || id == 0) return;
+        cin.ignore();
+
+        string facility;
+        cout << "Объект: ";
+        getline(cin, facility);
+
+        try {
+            if (replica.verifyMemberAccess(id, facility)) {
+                cout << "Доступ разрешен\n";
+            }
+        }
+        catch (const AccessViolationError& e) {
+            cerr << "Отказано: " << e.what() << endl;
+        }
+        catch (const runtime_error& e) {
+            cerr << "Ошибка: " << e.what() << endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
 
     setlocale(LC_ALL, "Russian");
+
+    if (argc > 1 && string(argv[1]) == "--bench-shards") {
+        runShardBenchmark();
+        return 0;
+    }
+
+    if (argc > 1 && string(argv[1]) == "--bench-events") {
+        runEventStoreBenchmark();
+        return 0;
+    }
+
+    if (argc > 1 && string(argv[1]) == "--bench-fold") {
+        runCaseFoldBenchmark();
+        return 0;
+    }
+
+    if (argc > 2 && string(argv[1]) == "--unlink-replica") {
+        try {
+            SharedMemorySegment::unlink(argv[2]);
+        }
+        catch (const exception& e) {
+            cerr << "Ошибка: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc > 2 && string(argv[1]) == "--replica") {
+        try {
+            runReplicaReader(argv[2]);
+        }
+        catch (const exception& e) {
+            cerr << "Ошибка: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
     AccessManagementSystem<CampusFacility> system;
 
     try {
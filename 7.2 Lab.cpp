@@ -2,7 +2,28 @@
 #include <thread>
 #include <mutex>
 #include <chrono>
-#include <random>
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+// Counter-based generator (SplitMix64): the value depends only on
+// (seed, battle, turn), so each battle is reproducible and parallel
+// battles share no generator state.
+inline uint64_t mixBits(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t combatRandom(uint64_t seed, uint64_t battleId, uint32_t turn) {
+    return mixBits(mixBits(seed ^ mixBits(battleId)) ^ turn);
+}
+
+// Uniform value in [1, limit] without modulo bias.
+inline int rollDamage(uint64_t bits, int limit) {
+    return 1 + static_cast<int>(((bits >> 32) * static_cast<uint64_t>(limit)) >> 32);
+}
 
 class Fighter {
 private:
@@ -39,17 +60,17 @@ public:
     }
 };
 
-void simulateCombat(Fighter& firstFighter, Fighter& secondFighter) {
-    std::random_device randomDevice;
-    std::mt19937 randomEngine(randomDevice());
-    std::uniform_int_distribution<> damageRange(1, firstFighter.getAttackPower());
+void simulateCombat(Fighter& firstFighter, Fighter& secondFighter, uint64_t seed, uint64_t battleId) {
+    Fighter* attacker = &firstFighter;
+    Fighter* defender = &secondFighter;
+    uint32_t turn = 0;
 
-    while (firstFighter.isStillAlive() && secondFighter.isStillAlive()) {
-        int damageDealt = damageRange(randomEngine);
+    while (attacker->isStillAlive() && defender->isStillAlive()) {
+        int damageDealt = rollDamage(combatRandom(seed, battleId, turn++), attacker->getAttackPower());
 
-        secondFighter.receiveDamage(damageDealt);
+        defender->receiveDamage(damageDealt);
 
-        std::cout << firstFighter.getName() << " attacks " << secondFighter.getName()
+        std::cout << attacker->getName() << " attacks " << defender->getName()
                   << " dealing " << damageDealt << " damage!" << std::endl;
 
         firstFighter.showStatus();
@@ -58,7 +79,7 @@ void simulateCombat(Fighter& firstFighter, Fighter& secondFighter) {
 
         std::this_thread::sleep_for(std::chrono::seconds(1));
 
-        std::swap(firstFighter, secondFighter);
+        std::swap(attacker, defender);
     }
 
     if (firstFighter.isStillAlive()) {
@@ -68,14 +89,23 @@ void simulateCombat(Fighter& firstFighter, Fighter& secondFighter) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    uint64_t seed = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    if (argc > 1) {
+        try {
+            seed = std::stoull(argv[1]);
+        } catch (const std::exception&) {
+            std::cerr << "Usage: " << argv[0] << " [seed]" << std::endl;
+            return 1;
+        }
+    }
     Fighter player("Knight", 100, 20);
     Fighter enemy("Dragon", 150, 15);
 
     std::cout << "Battle begins: " << player.getName() 
-              << " vs " << enemy.getName() << "!" << std::endl;
+              << " vs " << enemy.getName() << "! (seed " << seed << ")" << std::endl;
 
-    std::thread combatThread(simulateCombat, std::ref(player), std::ref(enemy));
+    std::thread combatThread(simulateCombat, std::ref(player), std::ref(enemy), seed, 0);
     combatThread.join();
 
     return 0;
@@ -1,3 +1,9 @@
+// Нужен C++20 (<latch>, std::atomic_ref, std::erase_if):
+// g++ -std=c++20 -pthread, MSVC /std:c++20.
+#if !(__cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L))
+#error "Требуется C++20: соберите с -std=c++20"
+#endif
+
 #include <iostream>
 #include <string>
 #include <vector>
@@ -6,549 +12,2807 @@
 #include <stdexcept>
 #include <typeinfo>
 #include <ctime>
+#include <array>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstdio>
+#include <cstdint>
+#include <iterator>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <string_view>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <charconv>
+#include <deque>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <tuple>
+#include <optional>
+#include <latch>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define DAMAGE_KERNEL_AVX2
+#endif
+
+// Отметка времени журнала в том же виде, что у ctime: названия дней и месяцев
+// берутся из таблиц, а не из текущей локали, как это сделал бы strftime.
+// Ее используют асинхронный EventLogger и декодер двоичного журнала.
+inline std::string formatLogTime(std::chrono::system_clock::time_point time) {
+    static const char* const dayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static const char* const monthNames[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                             "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    time_t seconds = std::chrono::system_clock::to_time_t(time);
+    tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.3s %.3s%3d %.2d:%.2d:%.2d %d\n",
+                  dayNames[local.tm_wday], monthNames[local.tm_mon], local.tm_mday,
+                  local.tm_hour, local.tm_min, local.tm_sec, 1900 + local.tm_year);
+    return buffer;
+}
+
+enum class LoggingMode {
+    Synchronous,
+    Asynchronous
+};
 
+// В асинхронном режиме recordEvent только кладёт сообщение с сырой отметкой
+// времени в кольцевой буфер своего потока (один писатель, один читатель, без
+// блокировок). Фоновый поток форматирует время и пишет события пачками:
+// по таймеру, при заполнении буфера до порога и при завершении работы.
 template<typename T>
 class EventLogger {
 private:
+    struct PendingEvent {
+        std::chrono::system_clock::time_point time;
+        T message;
+    };
+
+    class ThreadBuffer {
+    private:
+        std::vector<PendingEvent> slots;
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+
+    public:
+        explicit ThreadBuffer(size_t capacity) : slots(capacity) {}
+
+        size_t size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        bool push(PendingEvent&& event) {
+            size_t position = tail.load(std::memory_order_relaxed);
+            if (position - head.load(std::memory_order_acquire) == slots.size()) return false;
+            slots[position % slots.size()] = std::move(event);
+            tail.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        template<typename Consumer>
+        void drain(Consumer consume) {
+            size_t position = head.load(std::memory_order_relaxed);
+            size_t end = tail.load(std::memory_order_acquire);
+            for (; position != end; ++position) {
+                consume(slots[position % slots.size()]);
+            }
+            head.store(end, std::memory_order_release);
+        }
+    };
+
     std::ofstream logStream;
-    
+    LoggingMode loggingMode;
+    size_t flushThreshold;
+    std::chrono::milliseconds flushInterval;
+    uint64_t loggerId;
+
+    std::mutex buffersLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
+    std::mutex wakeLock;
+    std::condition_variable wakeWriter;
+    bool stopping = false;
+    std::thread writerThread;
+
+    static uint64_t nextLoggerId() {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    // Буферы принадлежат логгеру и освобождаются в его деструкторе. Поток
+    // хранит только слабую ссылку и быстрый указатель, который действителен,
+    // пока жив логгер с этим loggerId; записи умерших логгеров вычищаются
+    // при регистрации нового буфера.
+    struct LocalBuffer {
+        std::weak_ptr<ThreadBuffer> owner;
+        ThreadBuffer* buffer = nullptr;
+    };
+
+    ThreadBuffer& localBuffer() {
+        thread_local std::unordered_map<uint64_t, LocalBuffer> ownBuffers;
+        auto it = ownBuffers.find(loggerId);
+        if (it != ownBuffers.end()) return *it->second.buffer;
+
+        std::erase_if(ownBuffers, [](const auto& entry) { return entry.second.owner.expired(); });
+        auto buffer = std::make_shared<ThreadBuffer>(flushThreshold * 4);
+        {
+            std::lock_guard<std::mutex> lock(buffersLock);
+            threadBuffers.push_back(buffer);
+        }
+        ownBuffers.emplace(loggerId, LocalBuffer{buffer, buffer.get()});
+        return *buffer;
+    }
+
+    void writeBatch() {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(buffersLock);
+            buffers = threadBuffers;
+        }
+
+        std::string batch;
+        time_t formattedSecond = 0;
+        std::string formattedTime;
+        for (auto& buffer : buffers) {
+            buffer->drain([&](PendingEvent& event) {
+                time_t second = std::chrono::system_clock::to_time_t(event.time);
+                if (formattedTime.empty() || second != formattedSecond) {
+                    formattedTime = formatLogTime(event.time);
+                    formattedSecond = second;
+                }
+                std::ostringstream line;
+                line << formattedTime << ": " << event.message << '\n';
+                batch += line.str();
+                event.message = T();
+            });
+        }
+        if (!batch.empty()) {
+            logStream.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            logStream.flush();
+        }
+    }
+
+    void runWriter() {
+        std::unique_lock<std::mutex> lock(wakeLock);
+        while (!stopping) {
+            wakeWriter.wait_for(lock, flushInterval);
+            lock.unlock();
+            writeBatch();
+            lock.lock();
+        }
+        lock.unlock();
+        writeBatch();
+    }
+
 public:
-    EventLogger(const std::string& logFilename) {
+    EventLogger(const std::string& logFilename, LoggingMode mode = LoggingMode::Synchronous,
+                size_t batchSize = 1024, std::chrono::milliseconds interval = std::chrono::milliseconds(200))
+        : loggingMode(mode), flushThreshold(batchSize), flushInterval(interval), loggerId(nextLoggerId()) {
         logStream.open(logFilename, std::ios::app);
         if (!logStream) {
             throw std::runtime_error("Не удалось открыть файл журнала");
         }
+        if (loggingMode == LoggingMode::Asynchronous) {
+            writerThread = std::thread([this] { runWriter(); });
+        }
     }
     
     ~EventLogger() {
+        if (writerThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(wakeLock);
+                stopping = true;
+            }
+            wakeWriter.notify_one();
+            writerThread.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(buffersLock);
+            threadBuffers.clear();
+        }
         if (logStream.is_open()) {
             logStream.close();
         }
     }
     
     void recordEvent(const T& eventMessage) {
+        if (loggingMode == LoggingMode::Asynchronous) {
+            ThreadBuffer& buffer = localBuffer();
+            PendingEvent event{std::chrono::system_clock::now(), eventMessage};
+            while (!buffer.push(std::move(event))) {
+                wakeWriter.notify_one();
+                std::this_thread::yield();
+            }
+            if (buffer.size() >= flushThreshold) {
+                wakeWriter.notify_one();
+            }
+            return;
+        }
+
         time_t currentTime = time(0);
         char* timeString = ctime(&currentTime);
         logStream << timeString << ": " << eventMessage << std::endl;
     }
 };
 
+// Типизированный двоичный журнал: вместо готовой строки пишется код события,
+// время в миллисекундах и числовые аргументы (varint). Имена сущностей и
+// предметов заносятся в таблицу строк один раз, дальше на них ссылаются по ID.
+// Текст собирает только декодер (--decode) в формате текстового журнала.
+enum class GameEventId : uint8_t {
+    SessionStarted = 0,
+    StringDefined,
+    CombatStarted,
+    PlayerAttacked,
+    ItemUsed,
+    CreatureDefeated,
+    CreatureAttacked,
+    CombatEnded,
+    EventCount
+};
+
+constexpr int gameEventArity[] = {0, 0, 2, 3, 2, 3, 3, 1};
+
+class BinaryEventLog {
+private:
+    std::ofstream logStream;
+    std::vector<uint8_t> pending;
+    std::unordered_map<std::string, uint32_t> stringIds;
+    size_t flushThreshold;
+
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            pending.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        pending.push_back(static_cast<uint8_t>(value));
+    }
+
+    void writeHeader(GameEventId id) {
+        pending.push_back(static_cast<uint8_t>(id));
+        writeVarint(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count()));
+    }
+
+public:
+    BinaryEventLog(const std::string& logFilename, size_t bufferSize = 64 * 1024)
+        : logStream(logFilename, std::ios::binary | std::ios::app), flushThreshold(bufferSize) {
+        if (!logStream) {
+            throw std::runtime_error("Не удалось открыть файл журнала");
+        }
+        pending.reserve(flushThreshold + 64);
+        writeHeader(GameEventId::SessionStarted);
+    }
+
+    ~BinaryEventLog() {
+        flush();
+    }
+
+    uint32_t intern(const std::string& text) {
+        auto it = stringIds.find(text);
+        if (it != stringIds.end()) return it->second;
+
+        uint32_t id = static_cast<uint32_t>(stringIds.size());
+        stringIds.emplace(text, id);
+        writeHeader(GameEventId::StringDefined);
+        writeVarint(id);
+        writeVarint(text.size());
+        pending.insert(pending.end(), text.begin(), text.end());
+        return id;
+    }
+
+    void record(GameEventId id, uint64_t first = 0, uint64_t second = 0, uint64_t third = 0) {
+        writeHeader(id);
+        const uint64_t arguments[] = {first, second, third};
+        for (int i = 0; i < gameEventArity[static_cast<int>(id)]; ++i) {
+            writeVarint(arguments[i]);
+        }
+        if (pending.size() >= flushThreshold) flush();
+    }
+
+    void flush() {
+        if (pending.empty()) return;
+        logStream.write(reinterpret_cast<const char*>(pending.data()), static_cast<std::streamsize>(pending.size()));
+        logStream.flush();
+        pending.clear();
+    }
+};
+
+void decodeEventLog(const std::string& logFilename, std::ostream& output) {
+    std::ifstream input(logFilename, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Не удалось открыть файл журнала");
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    size_t position = 0;
+
+    auto readVarint = [&]() {
+        uint64_t value = 0;
+        for (int shift = 0; position < data.size(); shift += 7) {
+            uint8_t byte = data[position++];
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Журнал обрывается посреди записи");
+    };
+
+    std::vector<std::string> strings;
+    auto text = [&strings](uint64_t id) -> const std::string& {
+        if (id >= strings.size()) throw std::runtime_error("Ссылка на неизвестную строку журнала");
+        return strings[id];
+    };
+
+    while (position < data.size()) {
+        uint8_t code = data[position++];
+        if (code >= static_cast<uint8_t>(GameEventId::EventCount)) {
+            throw std::runtime_error("Неизвестный код события в журнале");
+        }
+        GameEventId id = static_cast<GameEventId>(code);
+        std::chrono::system_clock::time_point time{std::chrono::milliseconds(readVarint())};
+
+        if (id == GameEventId::SessionStarted) {
+            strings.clear();
+            continue;
+        }
+        if (id == GameEventId::StringDefined) {
+            uint64_t stringId = readVarint();
+            uint64_t length = readVarint();
+            if (position + length > data.size()) throw std::runtime_error("Журнал обрывается посреди записи");
+            // Номера строк выдаются подряд, так что новый номер равен числу известных строк.
+            if (stringId > strings.size()) throw std::runtime_error("Журнал поврежден: неверный номер строки");
+            if (stringId == strings.size()) strings.emplace_back();
+            strings[stringId].assign(reinterpret_cast<const char*>(&data[position]), length);
+            position += length;
+            continue;
+        }
+
+        uint64_t arguments[3] = {0, 0, 0};
+        for (int i = 0; i < gameEventArity[code]; ++i) arguments[i] = readVarint();
+
+        output << formatLogTime(time) << ": ";
+
+        switch (id) {
+            case GameEventId::CombatStarted:
+                output << "Битва между " << text(arguments[0]) << " и " << text(arguments[1]);
+                break;
+            case GameEventId::PlayerAttacked:
+            case GameEventId::CreatureAttacked:
+                output << text(arguments[0]) << " атакует " << text(arguments[1]);
+                break;
+            case GameEventId::ItemUsed:
+                output << text(arguments[0]) << " использует: " << text(arguments[1]);
+                break;
+            case GameEventId::CreatureDefeated:
+                output << text(arguments[0]) << " побеждает " << text(arguments[1])
+                       << " и получает " << arguments[2] << " опыта";
+                break;
+            case GameEventId::CombatEnded:
+                output << "Конец битвы: " << text(arguments[0]);
+                break;
+            default:
+                break;
+        }
+        output << "\n";
+    }
+}
+
 class GameWorldException : public std::runtime_error {
 public:
     GameWorldException(const std::string& message) : std::runtime_error(message) {}
 };
 
-class GameItem {
-protected:
-    std::string itemName;
-    std::string itemDescription;
-    
-public:
-    GameItem(const std::string& name, const std::string& description) 
-        : itemName(name), itemDescription(description) {}
-        
-    virtual ~GameItem() {}
-    
-    virtual void activate() = 0;
-    virtual std::string saveData() const = 0;
-    virtual void loadData(const std::string& savedData) = 0;
-    
-    std::string getName() const { return itemName; }
-    std::string getDescription() const { return itemDescription; }
+// Двоичное сохранение: заголовок (сигнатура, версия, размер и CRC-32 данных)
+// и данные персонажа вместе с инвентарём в одном файле. Запись идёт во
+// временный файл, который после fsync переименовывается поверх старого,
+// поэтому сбой посреди записи оставляет прежнее сохранение целым.
+// Версии: 1 — предметы без количества, 2 — стопки с количеством,
+// 3 — базовые характеристики и позиция надетого снаряжения.
+constexpr uint32_t SAVE_MAGIC = 0x56415347;
+constexpr uint32_t SAVE_FORMAT_VERSION = 3;
+constexpr uint32_t OLDEST_SAVE_FORMAT_VERSION = 1;
+
+struct SaveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t payloadSize;
+    uint32_t checksum;
+    uint32_t reserved;
 };
 
-class CombatGear : public GameItem {
+constexpr std::array<uint32_t, 256> makeCrc32Table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+        }
+        table[i] = value;
+    }
+    return table;
+}
+
+inline uint32_t crc32(const uint8_t* data, size_t size) {
+    static constexpr std::array<uint32_t, 256> table = makeCrc32Table();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+class SaveWriter {
 private:
-    int damageBonus;
-    
+    std::vector<uint8_t> buffer;
+
 public:
-    CombatGear(const std::string& name, const std::string& desc, int bonus)
-        : GameItem(name, desc), damageBonus(bonus) {}
-        
-    void activate() override {
-        std::cout << "Экипировано: " << itemName << " (+" << damageBonus << " к урону)" << std::endl;
+    template<typename Value>
+    void put(Value value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(Value));
     }
-    
-    int getDamageBonus() const { return damageBonus; }
-    
-    std::string saveData() const override {
-        return "Оружие," + itemName + "," + itemDescription + "," + std::to_string(damageBonus);
+
+    void putString(std::string_view text) {
+        put<uint32_t>(static_cast<uint32_t>(text.size()));
+        buffer.insert(buffer.end(), text.begin(), text.end());
     }
-    
-    void loadData(const std::string& savedData) override {
-        size_t firstDelim = savedData.find(',');
-        size_t secondDelim = savedData.find(',', firstDelim+1);
-        size_t thirdDelim = savedData.find(',', secondDelim+1);
-        
-        if (firstDelim == std::string::npos || secondDelim == std::string::npos || thirdDelim == std::string::npos) {
-            throw GameWorldException("Некорректные данные снаряжения");
+
+    void putBytes(std::string_view bytes) {
+        buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+    }
+
+    // Число по 7 бит в байте, старший бит — признак продолжения.
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
         }
-        
-        itemName = savedData.substr(firstDelim+1, secondDelim-firstDelim-1);
-        itemDescription = savedData.substr(secondDelim+1, thirdDelim-secondDelim-1);
-        damageBonus = std::stoi(savedData.substr(thirdDelim+1));
+        buffer.push_back(static_cast<uint8_t>(value));
     }
-};
 
+    const std::vector<uint8_t>& data() const { return buffer; }
+};
 
-class HealingItem : public GameItem {
+class SaveReader {
 private:
-    int healthRestore;
-    
+    const uint8_t* cursor;
+    const uint8_t* end;
+
+    void require(size_t size) const {
+        if (static_cast<size_t>(end - cursor) < size) {
+            throw GameWorldException("Файл сохранения поврежден");
+        }
+    }
+
 public:
-    HealingItem(const std::string& name, const std::string& desc, int heal)
-        : GameItem(name, desc), healthRestore(heal) {}
-        
-    void activate() override {
-        std::cout << "Использовано: " << itemName << " (восстанавливает " << healthRestore << " здоровья)" << std::endl;
+    SaveReader(const uint8_t* data, size_t size) : cursor(data), end(data + size) {}
+
+    template<typename Value>
+    Value get() {
+        require(sizeof(Value));
+        Value value;
+        std::memcpy(&value, cursor, sizeof(Value));
+        cursor += sizeof(Value);
+        return value;
     }
-    
-    int getHealAmount() const { return healthRestore; }
-    
-    std::string saveData() const override {
-        return "Зелье," + itemName + "," + itemDescription + "," + std::to_string(healthRestore);
+
+    std::string getString() {
+        return std::string(getStringView());
     }
-    
-    void loadData(const std::string& savedData) override {
-        size_t firstDelim = savedData.find(',');
-        size_t secondDelim = savedData.find(',', firstDelim+1);
-        size_t thirdDelim = savedData.find(',', secondDelim+1);
-        
-        if (firstDelim == std::string::npos || secondDelim == std::string::npos || thirdDelim == std::string::npos) {
-            throw GameWorldException("Некорректные данные зелья");
+
+    // Строка внутри буфера чтения, без копирования.
+    std::string_view getStringView() {
+        uint32_t size = get<uint32_t>();
+        require(size);
+        std::string_view text(reinterpret_cast<const char*>(cursor), size);
+        cursor += size;
+        return text;
+    }
+
+    uint64_t getVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = get<uint8_t>();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
         }
-        
-        itemName = savedData.substr(firstDelim+1, secondDelim-firstDelim-1);
-        itemDescription = savedData.substr(secondDelim+1, thirdDelim-secondDelim-1);
-        healthRestore = std::stoi(savedData.substr(thirdDelim+1));
+        throw GameWorldException("Файл сохранения поврежден");
     }
+
+    bool finished() const { return cursor == end; }
 };
 
-class ItemStorage {
+inline void writeSaveFile(const std::string& saveFile, const SaveWriter& payload, uint32_t magic = SAVE_MAGIC,
+                          uint32_t version = SAVE_FORMAT_VERSION) {
+    SaveHeader header{magic, version, payload.data().size(),
+                      crc32(payload.data().data(), payload.data().size()), 0};
+    std::string temporaryFile = saveFile + ".tmp";
+#ifdef _WIN32
+    {
+        std::ofstream output(temporaryFile, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char*>(payload.data().data()),
+                     static_cast<std::streamsize>(payload.data().size()));
+        output.flush();
+        if (!output) throw GameWorldException("Ошибка сохранения персонажа");
+    }
+    std::remove(saveFile.c_str());
+#else
+    int descriptor = ::open(temporaryFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0) throw GameWorldException("Ошибка сохранения персонажа");
+    auto writeAll = [descriptor](const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(descriptor, bytes, size);
+            if (written <= 0) return false;
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+    bool written = writeAll(&header, sizeof(header)) &&
+                   writeAll(payload.data().data(), payload.data().size()) &&
+                   ::fsync(descriptor) == 0;
+    ::close(descriptor);
+    if (!written) {
+        std::remove(temporaryFile.c_str());
+        throw GameWorldException("Ошибка сохранения персонажа");
+    }
+#endif
+    if (std::rename(temporaryFile.c_str(), saveFile.c_str()) != 0) {
+        std::remove(temporaryFile.c_str());
+        throw GameWorldException("Ошибка сохранения персонажа");
+    }
+}
+
+// Файл сохранения, отображённый в память только для чтения (на Windows
+// читается целиком). Данные доступны после проверки заголовка и CRC;
+// принимаются версии от oldestVersion до newestVersion включительно.
+class MappedSaveFile {
 private:
-    std::vector<std::unique_ptr<GameItem>> storedItems;
-    
+    const uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    std::vector<uint8_t> fallback;
+    uint32_t fileVersion = 0;
+
 public:
-    void addItem(std::unique_ptr<GameItem> newItem) {
-        storedItems.push_back(std::move(newItem));
-    }
-    
-    void removeItem(const std::string& itemToRemove) {
-        for (auto it = storedItems.begin(); it != storedItems.end(); ++it) {
-            if ((*it)->getName() == itemToRemove) {
-                storedItems.erase(it);
-                return;
+    explicit MappedSaveFile(const std::string& saveFile, uint32_t magic = SAVE_MAGIC,
+                            uint32_t newestVersion = SAVE_FORMAT_VERSION,
+                            uint32_t oldestVersion = OLDEST_SAVE_FORMAT_VERSION) {
+#ifdef _WIN32
+        std::ifstream input(saveFile, std::ios::binary);
+        if (!input) throw GameWorldException("Ошибка загрузки персонажа");
+        fallback.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        mapped = fallback.data();
+        mappedSize = fallback.size();
+#else
+        int descriptor = ::open(saveFile.c_str(), O_RDONLY);
+        if (descriptor < 0) throw GameWorldException("Ошибка загрузки персонажа");
+        struct stat info;
+        if (::fstat(descriptor, &info) != 0) {
+            ::close(descriptor);
+            throw GameWorldException("Ошибка загрузки персонажа");
+        }
+        mappedSize = static_cast<size_t>(info.st_size);
+        if (mappedSize > 0) {
+            void* address = ::mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (address == MAP_FAILED) {
+                ::close(descriptor);
+                throw GameWorldException("Ошибка загрузки персонажа");
             }
+            mapped = static_cast<const uint8_t*>(address);
         }
-        throw GameWorldException("Предмет не найден в инвентаре");
+        ::close(descriptor);
+#endif
+        SaveHeader header;
+        if (mappedSize < sizeof(header)) throw GameWorldException("Файл сохранения поврежден");
+        std::memcpy(&header, mapped, sizeof(header));
+        if (header.magic != magic) throw GameWorldException("Файл не является сохранением игры");
+        if (header.version < oldestVersion || header.version > newestVersion) {
+            throw GameWorldException("Неподдерживаемая версия сохранения: " + std::to_string(header.version));
+        }
+        fileVersion = header.version;
+        if (header.payloadSize != mappedSize - sizeof(header) ||
+            crc32(payload(), header.payloadSize) != header.checksum) {
+            throw GameWorldException("Файл сохранения поврежден");
+        }
+    }
+
+    MappedSaveFile(const MappedSaveFile&) = delete;
+    MappedSaveFile& operator=(const MappedSaveFile&) = delete;
+
+    ~MappedSaveFile() {
+#ifndef _WIN32
+        if (mapped) ::munmap(const_cast<uint8_t*>(mapped), mappedSize);
+#endif
     }
+
+    const uint8_t* payload() const { return mapped + sizeof(SaveHeader); }
+    size_t payloadSize() const { return mappedSize - sizeof(SaveHeader); }
+    uint32_t version() const { return fileVersion; }
+};
+
+// Ошибка разбора текстового файла с указанием строки и столбца.
+class RecordParseError : public GameWorldException {
+private:
+    size_t errorLine;
+    size_t errorColumn;
+    
+public:
+    RecordParseError(const std::string& message, size_t line, size_t column)
+        : GameWorldException("Строка " + std::to_string(line) + ", столбец " +
+                             std::to_string(column) + ": " + message),
+          errorLine(line), errorColumn(column) {}
+    
+    size_t line() const { return errorLine; }
+    size_t column() const { return errorColumn; }
+};
+
+// Поля одной записи CSV читаются как string_view прямо из буфера записи.
+// Поле в кавычках может содержать запятые и переводы строк, кавычка внутри
+// удваивается; только такие поля копируются во внутренний буфер читателя.
+// Буферов несколько, так что поля одной записи остаются действительными вместе.
+class CsvFieldReader {
+private:
+    std::string_view record;
+    size_t position = 0;
+    size_t firstLine;
+    bool exhausted = false;
+    std::array<std::string, 4> unescaped;
+    size_t nextBuffer = 0;
     
-    GameItem* findItem(const std::string& itemName) {
-        for (auto& item : storedItems) {
-            if (item->getName() == itemName) {
-                return item.get();
+    [[noreturn]] void fail(const std::string& message, size_t offset) const {
+        size_t line = firstLine;
+        size_t lineStart = 0;
+        for (size_t i = 0; i < offset && i < record.size(); ++i) {
+            if (record[i] == '\n') {
+                ++line;
+                lineStart = i + 1;
             }
         }
-        return nullptr;
+        throw RecordParseError(message, line, offset - lineStart + 1);
     }
     
-    void displayContents() const {
-        if (storedItems.empty()) {
-            std::cout << "Инвентарь пуст" << std::endl;
-            return;
+public:
+    explicit CsvFieldReader(std::string_view line, size_t lineNumber = 1)
+        : record(line), firstLine(lineNumber) {}
+    
+    bool atEnd() const { return exhausted; }
+    
+    std::string_view nextText() {
+        if (exhausted) {
+            fail("ожидалось еще одно поле", record.size());
         }
         
-        std::cout << "Содержимое инвентаря:" << std::endl;
-        for (const auto& item : storedItems) {
-            std::cout << "• " << item->getName() << ": " << item->getDescription() << std::endl;
+        if (position < record.size() && record[position] == '"') {
+            size_t start = ++position;
+            bool hasEscapes = false;
+            while (true) {
+                size_t quote = record.find('"', position);
+                if (quote == std::string_view::npos) {
+                    fail("нет закрывающей кавычки", start - 1);
+                }
+                if (quote + 1 < record.size() && record[quote + 1] == '"') {
+                    hasEscapes = true;
+                    position = quote + 2;
+                    continue;
+                }
+                position = quote + 1;
+                break;
+            }
+            std::string_view field = record.substr(start, position - 1 - start);
+            
+            if (position == record.size()) {
+                exhausted = true;
+            } else if (record[position] == ',') {
+                ++position;
+            } else {
+                fail("после закрывающей кавычки ожидалась запятая", position);
+            }
+            
+            if (!hasEscapes) return field;
+            std::string& buffer = unescaped[nextBuffer++ % unescaped.size()];
+            buffer.clear();
+            for (size_t i = 0; i < field.size(); ++i) {
+                buffer.push_back(field[i]);
+                if (field[i] == '"') ++i;
+            }
+            return buffer;
+        }
+        
+        size_t delimiter = record.find(',', position);
+        std::string_view field;
+        if (delimiter == std::string_view::npos) {
+            field = record.substr(position);
+            position = record.size();
+            exhausted = true;
+        } else {
+            field = record.substr(position, delimiter - position);
+            position = delimiter + 1;
         }
+        return field;
     }
     
-    void saveInventory(const std::string& storageFile) const {
-        std::ofstream outputFile(storageFile);
-        if (!outputFile) {
-            throw GameWorldException("Ошибка сохранения инвентаря");
-        }
+    int nextInt() {
+        // Столбец ошибки считается от первого символа значения, а не от кавычки.
+        size_t start = position;
+        if (start < record.size() && record[start] == '"') ++start;
+        std::string_view field = nextText();
+        size_t skipped = 0;
+        while (skipped < field.size() && field[skipped] == ' ') ++skipped;
+        while (!field.empty() && field.back() == ' ') field.remove_suffix(1);
         
-        for (const auto& item : storedItems) {
-            outputFile << item->saveData() << "\n";
+        int value = 0;
+        const char* first = field.data() + skipped;
+        const char* last = field.data() + field.size();
+        if (first < last && *first == '+') ++first;
+        auto [end, error] = std::from_chars(first, last, value);
+        if (error == std::errc::result_out_of_range) {
+            fail("число вне допустимого диапазона", start + skipped);
+        }
+        if (error != std::errc() || end != last) {
+            fail("ожидалось целое число", start + skipped);
         }
+        return value;
     }
     
-    void loadInventory(const std::string& storageFile) {
-        std::ifstream inputFile(storageFile);
-        if (!inputFile) {
-            throw GameWorldException("Ошибка загрузки инвентаря");
+    void expectEnd() const {
+        if (!exhausted) {
+            fail("лишние поля в записи", position);
+        }
+    }
+};
+
+// Записывает поле CSV, заключая его в кавычки только при необходимости.
+void appendCsvField(std::string& out, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.append(field);
+        return;
+    }
+    out.push_back('"');
+    for (char c : field) {
+        if (c == '"') out.push_back('"');
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+// Потоковое чтение записей CSV блоками: файл не делится на строки через
+// getline, записи передаются обработчику как string_view внутри блока.
+// Незавершенная запись в конце блока переносится в начало следующего.
+// Как и в CsvFieldReader, кавычка открывает поле только в его начале, а
+// закрывает — только перед запятой, концом строки или файла; кавычка
+// посреди поля без кавычек остается обычным символом.
+template<typename RecordHandler>
+void forEachCsvRecord(std::istream& input, RecordHandler&& handleRecord,
+                      size_t blockSize = 1 << 16) {
+    std::vector<char> buffer(blockSize);
+    size_t filled = 0;
+    size_t recordStart = 0;
+    size_t scanned = 0;
+    size_t currentLine = 1;
+    size_t recordLine = 1;
+    bool inQuotes = false;
+    bool fieldStart = true;
+    bool quotePending = false;
+    
+    auto emit = [&](size_t end) {
+        std::string_view record(buffer.data() + recordStart, end - recordStart);
+        if (!record.empty() && record.back() == '\r') record.remove_suffix(1);
+        if (!record.empty()) handleRecord(record, recordLine);
+    };
+    
+    while (true) {
+        if (recordStart > 0) {
+            std::memmove(buffer.data(), buffer.data() + recordStart, filled - recordStart);
+            filled -= recordStart;
+            scanned -= recordStart;
+            recordStart = 0;
+        }
+        if (filled == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
         }
         
-        storedItems.clear();
-        std::string dataLine;
-        while (std::getline(inputFile, dataLine)) {
-            size_t typePos = dataLine.find(',');
-            if (typePos == std::string::npos) continue;
-            
-            std::string itemType = dataLine.substr(0, typePos);
-            std::unique_ptr<GameItem> loadedItem;
-            
-            if (itemType == "Оружие") {
-                loadedItem = std::make_unique<CombatGear>("", "", 0);
-            } else if (itemType == "Зелье") {
-                loadedItem = std::make_unique<HealingItem>("", "", 0);
-            } else {
+        input.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+        size_t received = static_cast<size_t>(input.gcount());
+        if (received == 0) {
+            if (inQuotes && !quotePending) {
+                throw RecordParseError("нет закрывающей кавычки", recordLine, 1);
+            }
+            if (recordStart < filled) emit(filled);
+            return;
+        }
+        filled += received;
+        
+        for (; scanned < filled; ++scanned) {
+            char c = buffer[scanned];
+            if (quotePending) {
+                // Кавычка внутри поля в кавычках: удвоенная — символ поля,
+                // перед разделителем — конец поля, иначе обычный символ.
+                quotePending = false;
+                if (c == '"') continue;
+                if (c == ',' || c == '\r' || c == '\n') inQuotes = false;
+            }
+            if (inQuotes) {
+                if (c == '"') {
+                    quotePending = true;
+                } else if (c == '\n') {
+                    ++currentLine;
+                }
                 continue;
             }
-            
-            loadedItem->loadData(dataLine);
-            storedItems.push_back(std::move(loadedItem));
+            if (c == '"' && fieldStart) {
+                inQuotes = true;
+                fieldStart = false;
+            } else if (c == ',') {
+                fieldStart = true;
+            } else if (c == '\n') {
+                ++currentLine;
+                emit(scanned);
+                recordStart = scanned + 1;
+                recordLine = currentLine;
+                fieldStart = true;
+            } else {
+                fieldStart = false;
+            }
         }
     }
+}
+
+// Вид предмета хранится в самом объекте, чтобы использование и загрузка
+// выбирали обработчик одним switch без dynamic_cast.
+enum class ItemKind : uint8_t {
+    CombatGear,
+    HealingItem,
+    KindCount
 };
 
-class GameCreature {
-protected:
-    std::string creatureName;
-    int hitPoints;
-    int attackPower;
-    int defenseValue;
-    
-public:
-    GameCreature(const std::string& name, int hp, int atk, int def)
-        : creatureName(name), hitPoints(hp), attackPower(atk), defenseValue(def) {}
-        
-    virtual ~GameCreature() {}
+constexpr uint32_t NO_CATALOG_ENTRY = UINT32_MAX;
+
+// Неизменяемое описание предмета из каталога; строки указывают в
+// отображенный файл каталога и живут до конца программы.
+struct ItemDefinition {
+    uint32_t catalogId;
+    ItemKind kind;
+    std::string_view name;
+    std::string_view description;
+    int32_t value;
+};
+
+// Имя и описание предмета - либо собственные строки, либо ссылки на
+// определение в каталоге, общее для всех одинаковых предметов.
+// Предмет из каталога хранит только номер записи, а имя и описание читает
+// из каталога. Собственные строки лежат в отдельном выделении, которое есть
+// только у предметов вне каталога.
+class GameItem {
+private:
+    struct OwnedText {
+        std::string name;
+        std::string description;
+    };
     
-    virtual void performAttack(class GameCharacter& target) = 0;
+    std::unique_ptr<OwnedText> ownedText;
     
-    bool isAlive() const { return hitPoints > 0; }
+protected:
+    ItemKind itemKind;
+    uint32_t catalogId = NO_CATALOG_ENTRY;
     
-    void receiveDamage(int damage) {
-        hitPoints -= damage;
-        if (hitPoints < 0) hitPoints = 0;
+    void setText(std::string_view name, std::string_view description) {
+        ownedText = std::make_unique<OwnedText>(OwnedText{std::string(name), std::string(description)});
+        catalogId = NO_CATALOG_ENTRY;
     }
     
-    virtual std::string saveCreatureData() const {
-        return creatureName + "," + std::to_string(hitPoints) + "," + 
-               std::to_string(attackPower) + "," + std::to_string(defenseValue);
+public:
+    GameItem(ItemKind kind, std::string_view name, std::string_view description) : itemKind(kind) {
+        setText(name, description);
     }
     
-    virtual void loadCreatureData(const std::string& creatureData) {
-        size_t firstDelim = creatureData.find(',');
-        size_t secondDelim = creatureData.find(',', firstDelim+1);
-        size_t thirdDelim = creatureData.find(',', secondDelim+1);
-        
-        if (firstDelim == std::string::npos || secondDelim == std::string::npos || thirdDelim == std::string::npos) {
-            throw GameWorldException("Некорректные данные существа");
-        }
-        
-        creatureName = creatureData.substr(0, firstDelim);
-        hitPoints = std::stoi(creatureData.substr(firstDelim+1, secondDelim-firstDelim-1));
-        attackPower = std::stoi(creatureData.substr(secondDelim+1, thirdDelim-secondDelim-1));
-        defenseValue = std::stoi(creatureData.substr(thirdDelim+1));
-    }
+    explicit GameItem(const ItemDefinition& definition)
+        : itemKind(definition.kind), catalogId(definition.catalogId) {}
     
-    virtual void displayCreatureInfo() const {
-        std::cout << creatureName << " - Здоровье: " << hitPoints 
-                  << ", Атака: " << attackPower << ", Защита: " << defenseValue;
+    GameItem(const GameItem&) = delete;
+    GameItem& operator=(const GameItem&) = delete;
+        
+    virtual ~GameItem() {}
+    
+    virtual void activate() = 0;
+    virtual std::string saveData() const = 0;
+    virtual void loadFields(CsvFieldReader& fields) = 0;
+    
+    // Запись начинается с метки вида, дальше идут поля конкретного предмета.
+    void loadData(std::string_view savedData, size_t lineNumber = 1) {
+        CsvFieldReader fields(savedData, lineNumber);
+        fields.nextText();
+        loadFields(fields);
     }
     
-    std::string getName() const { return creatureName; }
-    int getHealth() const { return hitPoints; }
-    int getAttack() const { return attackPower; }
-    int getDefense() const { return defenseValue; }
+    ItemKind getKind() const { return itemKind; }
+    uint32_t getCatalogId() const { return catalogId; }
+    std::string_view getName() const;
+    std::string_view getDescription() const;
 };
 
-class ForestGoblin : public GameCreature {
+class CombatGear : public GameItem {
+private:
+    int damageBonus;
+    
 public:
-    ForestGoblin() : GameCreature("Лесной гоблин", 30, 8, 3) {}
+    CombatGear(std::string_view name, std::string_view desc, int bonus)
+        : GameItem(ItemKind::CombatGear, name, desc), damageBonus(bonus) {}
     
-    void performAttack(GameCharacter& target) override {
-        std::cout << "Гоблин атакует своим дубинкой!" << std::endl;
-        int damageDealt = attackPower - target.getDefense();
-        if (damageDealt > 0) {
-            target.receiveDamage(damageDealt);
-            std::cout << "Нанесено " << damageDealt << " урона!" << std::endl;
-        } else {
-            std::cout << "Атака не пробила защиту!" << std::endl;
-        }
+    explicit CombatGear(const ItemDefinition& definition)
+        : GameItem(definition), damageBonus(definition.value) {}
+        
+    void activate() override {
+        std::cout << "Экипировано: " << getName() << " (+" << damageBonus << " к урону)" << std::endl;
     }
     
-    std::string saveCreatureData() const override {
-        return "Гоблин," + GameCreature::saveCreatureData();
+    int getDamageBonus() const { return damageBonus; }
+    
+    std::string saveData() const override {
+        std::string record = "Оружие,";
+        appendCsvField(record, getName());
+        record.push_back(',');
+        appendCsvField(record, getDescription());
+        record.push_back(',');
+        record += std::to_string(damageBonus);
+        return record;
+    }
+    
+    void loadFields(CsvFieldReader& fields) override {
+        std::string_view name = fields.nextText();
+        std::string_view description = fields.nextText();
+        damageBonus = fields.nextInt();
+        fields.expectEnd();
+        setText(name, description);
     }
 };
 
-class AncientDragon : public GameCreature {
+
+class HealingItem : public GameItem {
+private:
+    int healthRestore;
+    
 public:
-    AncientDragon() : GameCreature("Древний дракон", 100, 20, 10) {}
+    HealingItem(std::string_view name, std::string_view desc, int heal)
+        : GameItem(ItemKind::HealingItem, name, desc), healthRestore(heal) {}
     
-    void performAttack(GameCharacter& target) override {
-        std::cout << "Дракон извергает пламя!" << std::endl;
-        int damageDealt = attackPower - target.getDefense();
-        if (damageDealt > 0) {
-            target.receiveDamage(damageDealt);
-            std::cout << "Нанесено " << damageDealt << " урона!" << std::endl;
-        } else {
-            std::cout << "Атака не пробила защиту!" << std::endl;
-        }
+    explicit HealingItem(const ItemDefinition& definition)
+        : GameItem(definition), healthRestore(definition.value) {}
+        
+    void activate() override {
+        std::cout << "Использовано: " << getName() << " (восстанавливает " << healthRestore << " здоровья)" << std::endl;
     }
     
-    std::string saveCreatureData() const override {
-        return "Дракон," + GameCreature::saveCreatureData();
+    int getHealAmount() const { return healthRestore; }
+    
+    std::string saveData() const override {
+        std::string record = "Зелье,";
+        appendCsvField(record, getName());
+        record.push_back(',');
+        appendCsvField(record, getDescription());
+        record.push_back(',');
+        record += std::to_string(healthRestore);
+        return record;
+    }
+    
+    void loadFields(CsvFieldReader& fields) override {
+        std::string_view name = fields.nextText();
+        std::string_view description = fields.nextText();
+        healthRestore = fields.nextInt();
+        fields.expectEnd();
+        setText(name, description);
     }
 };
 
-class UndeadWarrior : public GameCreature {
-public:
-    UndeadWarrior() : GameCreature("Нежить-воин", 40, 10, 5) {}
-    
-    void performAttack(GameCharacter& target) override {
-        std::cout << "Нежить атакует ржавым мечом!" << std::endl;
-        int damageDealt = attackPower - target.getDefense();
-        if (damageDealt > 0) {
-            target.receiveDamage(damageDealt);
-            std::cout << "Нанесено " << damageDealt << " урона!" << std::endl;
-        } else {
-            std::cout << "Атака не пробила защиту!" << std::endl;
-        }
+// Таблица видов предметов: метка в файле сохранения и создание пустого
+// предмета для загрузки. Новый вид добавляется строкой таблицы и значением
+// ItemKind; порядок строк проверяется при компиляции.
+struct ItemKindInfo {
+    ItemKind kind;
+    std::string_view savedTag;
+    std::unique_ptr<GameItem> (*create)(std::string_view name, std::string_view description, int value);
+    std::unique_ptr<GameItem> (*createDefined)(const ItemDefinition& definition);
+    int (*value)(const GameItem& item);
+};
+
+inline int itemValue(const CombatGear& item) { return item.getDamageBonus(); }
+inline int itemValue(const HealingItem& item) { return item.getHealAmount(); }
+
+template<typename Item>
+std::unique_ptr<GameItem> createItem(std::string_view name, std::string_view description, int value) {
+    return std::make_unique<Item>(name, description, value);
+}
+
+template<typename Item>
+std::unique_ptr<GameItem> createDefinedItem(const ItemDefinition& definition) {
+    return std::make_unique<Item>(definition);
+}
+
+template<typename Item>
+int readItemValue(const GameItem& item) {
+    return itemValue(static_cast<const Item&>(item));
+}
+
+constexpr ItemKindInfo itemKindTable[] = {
+    {ItemKind::CombatGear, "Оружие", &createItem<CombatGear>, &createDefinedItem<CombatGear>, &readItemValue<CombatGear>},
+    {ItemKind::HealingItem, "Зелье", &createItem<HealingItem>, &createDefinedItem<HealingItem>, &readItemValue<HealingItem>},
+};
+
+constexpr bool itemKindTableMatchesEnum() {
+    if (std::size(itemKindTable) != static_cast<size_t>(ItemKind::KindCount)) return false;
+    for (size_t i = 0; i < std::size(itemKindTable); ++i) {
+        if (itemKindTable[i].kind != static_cast<ItemKind>(i)) return false;
     }
-    
-    std::string saveCreatureData() const override {
-        return "Нежить," + GameCreature::saveCreatureData();
+    return true;
+}
+static_assert(itemKindTableMatchesEnum(), "itemKindTable должна перечислять ItemKind по порядку");
+
+inline const ItemKindInfo* findItemKind(std::string_view savedTag) {
+    for (const auto& info : itemKindTable) {
+        if (info.savedTag == savedTag) return &info;
     }
+    return nullptr;
+}
+
+// Версия каталога не зависит от версии сохранений. Нумерация продолжает
+// прежнюю общую, поэтому каталоги с заголовком версий 1-3 (формат тот же) читаются.
+constexpr uint32_t CATALOG_MAGIC = 0x54414349;
+constexpr uint32_t CATALOG_FORMAT_VERSION = 3;
+constexpr uint32_t OLDEST_CATALOG_FORMAT_VERSION = 1;
+
+// Запись каталога: смещения строк в общем пуле строк после таблицы записей.
+struct CatalogEntry {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t descriptionOffset;
+    uint32_t descriptionLength;
+    int32_t value;
+    uint8_t kind;
+    uint8_t reserved[3];
 };
 
-class GameCharacter {
+// Каталог предметов только для чтения. Файл строится заранее режимом
+// --build-catalog и отображается в память при запуске; записи отсортированы
+// по имени, а строки предметов указывают прямо в отображенные страницы,
+// поэтому несколько процессов игры делят одну копию в кэше страниц.
+class ItemCatalog {
 private:
-    std::string characterName;
-    int currentHealth;
-    int maximumHealth;
-    int attackStat;
-    int defenseStat;
-    int characterLevel;
-    int experiencePoints;
-    ItemStorage characterInventory;
+    std::unique_ptr<MappedSaveFile> mapping;
+    const CatalogEntry* entries = nullptr;
+    uint32_t entryCount = 0;
+    const char* strings = nullptr;
+    
+    ItemDefinition definitionAt(uint32_t id) const {
+        const CatalogEntry& entry = entries[id];
+        return ItemDefinition{id, static_cast<ItemKind>(entry.kind),
+                              std::string_view(strings + entry.nameOffset, entry.nameLength),
+                              std::string_view(strings + entry.descriptionOffset, entry.descriptionLength),
+                              entry.value};
+    }
     
 public:
-    GameCharacter(const std::string& name, int health, int attack, int defense)
-        : characterName(name), currentHealth(health), maximumHealth(health), 
-          attackStat(attack), defenseStat(defense), characterLevel(1), experiencePoints(0) {}
+    // Открывается один раз: предметы ссылаются на строки каталога до конца программы.
+    void open(const std::string& catalogFile) {
+        if (mapping) {
+            throw GameWorldException("Каталог предметов уже открыт");
+        }
+        auto mapped = std::make_unique<MappedSaveFile>(catalogFile, CATALOG_MAGIC, CATALOG_FORMAT_VERSION,
+                                                       OLDEST_CATALOG_FORMAT_VERSION);
+        SaveReader reader(mapped->payload(), mapped->payloadSize());
+        uint32_t count = reader.get<uint32_t>();
         
-    void attackTarget(GameCreature& enemy) {
-        int damageDealt = attackStat - enemy.getDefense();
-        if (damageDealt > 0) {
-            enemy.receiveDamage(damageDealt);
-            std::cout << characterName << " атакует " << enemy.getName() << " и наносит " << damageDealt << " урона!" << std::endl;
-        } else {
-            std::cout << characterName << " атакует " << enemy.getName() << ", но атака неэффективна!" << std::endl;
+        size_t tableBytes = static_cast<size_t>(count) * sizeof(CatalogEntry);
+        if (mapped->payloadSize() - sizeof(uint32_t) < tableBytes) {
+            throw GameWorldException("Каталог предметов поврежден");
         }
-    }
-    
-    void receiveDamage(int damageTaken) {
-        currentHealth -= damageTaken;
-        if (currentHealth < 0) {
-            currentHealth = 0;
-            throw GameWorldException(characterName + " повержен!");
+        const uint8_t* table = mapped->payload() + sizeof(uint32_t);
+        size_t stringBytes = mapped->payloadSize() - sizeof(uint32_t) - tableBytes;
+        
+        const CatalogEntry* catalogEntries = reinterpret_cast<const CatalogEntry*>(table);
+        for (uint32_t i = 0; i < count; ++i) {
+            const CatalogEntry& entry = catalogEntries[i];
+            if (entry.kind >= static_cast<uint8_t>(ItemKind::KindCount) ||
+                entry.nameOffset > stringBytes || entry.nameLength > stringBytes - entry.nameOffset ||
+                entry.descriptionOffset > stringBytes || entry.descriptionLength > stringBytes - entry.descriptionOffset) {
+                throw GameWorldException("Каталог предметов поврежден");
+            }
+        }
+        
+        mapping = std::move(mapped);
+        entries = catalogEntries;
+        entryCount = count;
+        strings = reinterpret_cast<const char*>(table + tableBytes);
+        for (uint32_t i = 1; i < count; ++i) {
+            if (!(definitionAt(i - 1).name < definitionAt(i).name)) {
+                mapping.reset();
+                entryCount = 0;
+                throw GameWorldException("Каталог предметов не отсортирован");
+            }
         }
     }
     
-    void restoreHealth(int healAmount) {
-        currentHealth += healAmount;
-        if (currentHealth > maximumHealth) currentHealth = maximumHealth;
-        std::cout << characterName << " восстанавливает " << healAmount << " здоровья!" << std::endl;
-    }
+    bool isOpen() const { return mapping != nullptr; }
     
-    void gainExperience(int expGained) {
-        experiencePoints += expGained;
-        if (experiencePoints >= 100) {
-            characterLevel++;
-            experiencePoints -= 100;
-            maximumHealth += 10;
-            currentHealth = maximumHealth;
-            attackStat += 2;
-            defenseStat += 1;
-            std::cout << characterName << " достиг уровня " << characterLevel << "!" << std::endl;
-        }
+    // Без проверки номера: для предметов, созданных по записям этого каталога.
+    std::string_view nameOf(uint32_t id) const {
+        return std::string_view(strings + entries[id].nameOffset, entries[id].nameLength);
     }
     
-    void useInventoryItem(const std::string& itemName) {
-        GameItem* item = characterInventory.findItem(itemName);
-        if (!item) {
-            throw GameWorldException("Предмет не найден в инвентаре");
-        }
-        
-        if (auto healingItem = dynamic_cast<HealingItem*>(item)) {
-            restoreHealth(healingItem->getHealAmount());
-            characterInventory.removeItem(itemName);
-        } else if (auto weaponItem = dynamic_cast<CombatGear*>(item)) {
-            attackStat += weaponItem->getDamageBonus();
-            std::cout << "Экипировано " << weaponItem->getName() << "! Бонус к атаке: " 
-                      << weaponItem->getDamageBonus() << std::endl;
-        }
+    std::string_view descriptionOf(uint32_t id) const {
+        return std::string_view(strings + entries[id].descriptionOffset, entries[id].descriptionLength);
     }
+    uint32_t size() const { return entryCount; }
     
-    void displayCharacterInfo() const {
-        std::cout << "Имя: " << characterName << ", Здоровье: " << currentHealth << "/" << maximumHealth
-                  << ", Атака: " << attackStat << ", Защита: " << defenseStat
-                  << ", Уровень: " << characterLevel << ", Опыт: " << experiencePoints << "/100" << std::endl;
+    ItemDefinition definition(uint32_t id) const {
+        if (id >= entryCount) {
+            throw GameWorldException("Нет такой записи в каталоге предметов");
+        }
+        return definitionAt(id);
     }
     
-    void saveCharacterProgress(const std::string& saveFile) const {
-        std::ofstream outputFile(saveFile);
-        if (!outputFile) {
-            throw GameWorldException("Ошибка сохранения персонажа");
+    std::optional<ItemDefinition> find(std::string_view name) const {
+        uint32_t low = 0, high = entryCount;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            std::string_view candidate(strings + entries[middle].nameOffset, entries[middle].nameLength);
+            if (candidate < name) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
         }
-        
-        outputFile << characterName << "\n";
-        outputFile << currentHealth << "\n";
-        outputFile << maximumHealth << "\n";
-        outputFile << attackStat << "\n";
-        outputFile << defenseStat << "\n";
-        outputFile << characterLevel << "\n";
-        outputFile << experiencePoints << "\n";
-        
-        characterInventory.saveInventory(saveFile + "_инвентарь");
+        if (low < entryCount && definitionAt(low).name == name) return definitionAt(low);
+        return std::nullopt;
     }
     
-    void loadCharacterProgress(const std::string& saveFile) {
-        std::ifstream inputFile(saveFile);
-        if (!inputFile) {
-            throw GameWorldException("Ошибка загрузки персонажа");
+    // Строит файл каталога из CSV в формате инвентаря: вид,имя,описание,значение.
+    static void build(const std::string& sourceFile, const std::string& catalogFile) {
+        std::ifstream input(sourceFile);
+        if (!input) {
+            throw GameWorldException("Не удалось открыть " + sourceFile);
         }
         
-        std::getline(inputFile, characterName);
+        struct SourceItem {
+            ItemKind kind;
+            std::string name;
+            std::string description;
+            int value;
+            size_t line;
+        };
+        std::vector<SourceItem> items;
+        forEachCsvRecord(input, [&items](std::string_view record, size_t lineNumber) {
+            CsvFieldReader fields(record, lineNumber);
+            std::string_view tag = fields.nextText();
+            const ItemKindInfo* kind = findItemKind(tag);
+            if (!kind) {
+                throw RecordParseError("неизвестный вид предмета", lineNumber, 1);
+            }
+            std::string name(fields.nextText());
+            std::string description(fields.nextText());
+            int value = fields.nextInt();
+            fields.expectEnd();
+            items.push_back(SourceItem{kind->kind, std::move(name), std::move(description), value, lineNumber});
+        });
         
-        std::string dataLine;
-        std::getline(inputFile, dataLine); currentHealth = std::stoi(dataLine);
-        std::getline(inputFile, dataLine); maximumHealth = std::stoi(dataLine);
-        std::getline(inputFile, dataLine); attackStat = std::stoi(dataLine);
-        std::getline(inputFile, dataLine); defenseStat = std::stoi(dataLine);
-        std::getline(inputFile, dataLine); characterLevel = std::stoi(dataLine);
-        std::getline(inputFile, dataLine); experiencePoints = std::stoi(dataLine);
+        std::sort(items.begin(), items.end(),
+                  [](const SourceItem& a, const SourceItem& b) { return a.name < b.name; });
+        for (size_t i = 1; i < items.size(); ++i) {
+            if (items[i].name == items[i - 1].name) {
+                throw RecordParseError("повторное имя предмета", items[i].line, 1);
+            }
+        }
         
-        characterInventory.loadInventory(saveFile + "_инвентарь");
+        std::string stringPool;
+        SaveWriter writer;
+        writer.put<uint32_t>(static_cast<uint32_t>(items.size()));
+        for (const auto& item : items) {
+            CatalogEntry entry{};
+            entry.nameOffset = static_cast<uint32_t>(stringPool.size());
+            entry.nameLength = static_cast<uint32_t>(item.name.size());
+            stringPool += item.name;
+            entry.descriptionOffset = static_cast<uint32_t>(stringPool.size());
+            entry.descriptionLength = static_cast<uint32_t>(item.description.size());
+            stringPool += item.description;
+            entry.value = item.value;
+            entry.kind = static_cast<uint8_t>(item.kind);
+            writer.put(entry);
+        }
+        writer.putBytes(stringPool);
+        writeSaveFile(catalogFile, writer, CATALOG_MAGIC, CATALOG_FORMAT_VERSION);
     }
-    
-    void addItemToInventory(std::unique_ptr<GameItem> newItem) {
-        characterInventory.addItem(std::move(newItem));
+};
+
+inline ItemCatalog& itemCatalog() {
+    static ItemCatalog catalog;
+    return catalog;
+}
+
+inline std::string_view GameItem::getName() const {
+    return ownedText ? std::string_view(ownedText->name) : itemCatalog().nameOf(catalogId);
+}
+
+inline std::string_view GameItem::getDescription() const {
+    return ownedText ? std::string_view(ownedText->description) : itemCatalog().descriptionOf(catalogId);
+}
+
+// Предмет из каталога, если там есть такое же определение; иначе предмет
+// с собственными строками.
+inline std::unique_ptr<GameItem> makeItem(ItemKind kind, std::string_view name,
+                                          std::string_view description, int value) {
+    const ItemKindInfo& info = itemKindTable[static_cast<size_t>(kind)];
+    std::optional<ItemDefinition> definition = itemCatalog().find(name);
+    if (definition && definition->kind == kind && definition->description == description &&
+        definition->value == value) {
+        return info.createDefined(*definition);
     }
-    
-    void showCharacterInventory() const {
-        characterInventory.displayContents();
+    return info.create(name, description, value);
+}
+
+// Стабильная ссылка на предмет в хранилище: номер ячейки и её поколение.
+// После удаления предмета поколение ячейки растёт, и старые ссылки перестают
+// находить предмет, даже если ячейку заняли заново.
+struct ItemHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const ItemHandle& other) const {
+        return slot == other.slot && generation == other.generation;
     }
-    
-    std::string getName() const { return characterName; }
-    int getHealth() const { return currentHealth; }
-    int getMaxHealth() const { return maximumHealth; }
-    int getAttack() const { return attackStat; }
-    int getDefense() const { return defenseStat; }
-    int getLevel() const { return characterLevel; }
-    int getExperience() const { return experiencePoints; }
 };
 
-class AdventureGame {
+// Одинаковые предметы (вид, имя, описание и значение) лежат в одной ячейке
+// со счетчиком: добавление увеличивает счетчик, использование уменьшает.
+struct ItemStack {
+    std::shared_ptr<GameItem> item;
+    uint32_t count;
+};
+
+// Список стопок разделяется со снимками состояния (copy-on-write):
+// снимок только увеличивает счетчик ссылок, а копия списка делается при
+// первом изменении, пока снимок еще жив. Предметы после добавления не
+// меняются, поэтому копия разделяет сами предметы, а счетчики копируются.
+//
+// Все открытые методы берут мьютекс хранилища, а transfer — мьютексы обоих
+// хранилищ, поэтому владелец может пользоваться инвентарем, пока другие
+// потоки переносят в него предметы или из него. Предметы отдаются как
+// shared_ptr: стопку могут забрать в другом потоке, а предмет должен жить,
+// пока им пользуются. Закрепленную стопку (надетое снаряжение) transfer
+// целиком не отдает.
+class ItemStorage {
+public:
+    using ItemList = std::vector<ItemStack>;
+    
+    static constexpr uint32_t NO_POSITION = UINT32_MAX;
+    
+    // Список стопок и позиция закрепленной стопки (NO_POSITION, если ее нет),
+    // взятые под одной блокировкой и поэтому согласованные между собой.
+    struct PinnedSnapshot {
+        std::shared_ptr<const ItemList> items;
+        uint32_t pinnedPosition;
+    };
+    
 private:
-    GameCharacter mainCharacter;
-    EventLogger<std::string> gameLogger;
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    struct Slot {
+        uint32_t denseIndex;
+        uint32_t generation;
+    };
+
+    std::shared_ptr<ItemList> storedItems = std::make_shared<ItemList>();
+    std::vector<uint32_t> denseSlots;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<std::string, std::vector<uint32_t>, NameHash, std::equal_to<>> nameIndex;
+    size_t totalItems = 0;
+    ItemHandle pinnedStack;
+    mutable std::mutex storageMutex;
     
-public:
-    AdventureGame(const std::string& playerName) 
-        : mainCharacter(playerName, 100, 10, 5), gameLogger("журнал_игры.txt") {
-        gameLogger.recordEvent("Начало игры. Персонаж: " + playerName);
+    static bool sameItem(const GameItem& first, const GameItem& second) {
+        if (&first == &second) return true;
+        return first.getKind() == second.getKind() && first.getName() == second.getName() &&
+               first.getDescription() == second.getDescription() &&
+               itemKindTable[static_cast<size_t>(first.getKind())].value(first) ==
+               itemKindTable[static_cast<size_t>(second.getKind())].value(second);
     }
     
-    void initiateCombat(GameCreature& enemy) {
-        gameLogger.recordEvent("Битва между " + mainCharacter.getName() + " и " + enemy.getName());
-        
-        std::cout << "\n=== НАЧАЛО БИТВЫ ===\n";
-        mainCharacter.displayCharacterInfo();
-        enemy.displayCreatureInfo();
-        std::cout << "====================\n";
-        
-        try {
-            while (mainCharacter.getHealth() > 0 && enemy.isAlive()) {
-
-                std::cout << "\nВаш ход:\n";
-                std::cout << "1. Атаковать\n";
-                std::cout << "2. Использовать предмет\n";
-                std::cout << "Выберите действие: ";
-                
-                int playerChoice;
-                std::cin >> playerChoice;
-                
-                if (playerChoice == 1) {
-                    mainCharacter.attackTarget(enemy);
-                    gameLogger.recordEvent(mainCharacter.getName() + " атакует " + enemy.getName());
-                } else if (playerChoice == 2) {
-                    mainCharacter.showCharacterInventory();
-                    std::cout << "Введите название предмета: ";
-                    std::string selectedItem;
-                    std::cin.ignore();
-                    std::getline(std::cin, selectedItem);
-                    
-                    try {
-                        mainCharacter.useInventoryItem(selectedItem);
-                        gameLogger.recordEvent(mainCharacter.getName() + " использует: " + selectedItem);
-                    } catch (const GameWorldException& error) {
-                        std::cerr << "Ошибка: " << error.what() << std::endl;
-                        continue;
-                    }
-                } else {
-                    std::cout << "Неверный выбор!" << std::endl;
-                    continue;
-                }
-                
-                if (!enemy.isAlive()) {
-                    int experienceReward = enemy.getAttack() * 5;
-                    mainCharacter.gainExperience(experienceReward);
-                    std::cout << enemy.getName() << " побежден! Получено " << experienceReward << " опыта.\n";
-                    gameLogger.recordEvent(mainCharacter.getName() + " побеждает " + enemy.getName() + 
-                               " и получает " + std::to_string(experienceReward) + " опыта");
-                    return;
-                }
-                
-                std::cout << "\nХод " << enemy.getName() << ":\n";
-                enemy.performAttack(mainCharacter);
-                gameLogger.recordEvent(enemy.getName() + " атакует " + mainCharacter.getName());
-                
-                std::cout << "\nТекущее состояние:\n";
-                mainCharacter.displayCharacterInfo();
-                enemy.displayCreatureInfo();
-                std::cout << "====================\n";
-            }
-        } catch (const GameWorldException& error) {
-            gameLogger.recordEvent("Конец битвы: " + std::string(error.what()));
-            throw;
+    // Дальше до public методы без блокировки: их вызывают под storageMutex.
+    ItemStack* stackAt(ItemHandle handle) const {
+        if (handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation) {
+            return nullptr;
         }
+        return &(*storedItems)[slots[handle.slot].denseIndex];
     }
     
-    void saveGameState() {
-        try {
-            mainCharacter.saveCharacterProgress("сохранение.txt");
-            gameLogger.recordEvent("Игра сохранена");
-            std::cout << "Игра сохранена!\n";
-        } catch (const GameWorldException& error) {
-            gameLogger.recordEvent("Ошибка сохранения: " + std::string(error.what()));
-            std::cerr << "Ошибка сохранения: " << error.what() << std::endl;
-        }
+    ItemHandle handleNamed(std::string_view itemName) const {
+        auto indexed = nameIndex.find(itemName);
+        if (indexed == nameIndex.end()) return ItemHandle{};
+        uint32_t slot = indexed->second.back();
+        return ItemHandle{slot, slots[slot].generation};
     }
     
-    void loadGameState() {
-        try {
-            mainCharacter.loadCharacterProgress("сохранение.txt");
-            gameLogger.recordEvent("Игра загружена");
-            std::cout << "Игра загружена!\n";
-        } catch (const GameWorldException& error) {
-            gameLogger.recordEvent("Ошибка загрузки: " + std::string(error.what()));
-            std::cerr << "Ошибка загрузки: " << error.what() << std::endl;
+    ItemList& mutableItems() {
+        if (storedItems.use_count() > 1) {
+            storedItems = std::make_shared<ItemList>(*storedItems);
         }
+        return *storedItems;
     }
     
-    void addItemToCharacter(std::unique_ptr<GameItem> newItem) {
-        mainCharacter.addItemToInventory(std::move(newItem));
+    // Если такой предмет уже есть, count добавляется к его стопке.
+    ItemHandle addStack(std::shared_ptr<GameItem> newItem, uint32_t count) {
+        if (count == 0) {
+            throw GameWorldException("Пустая стопка предметов");
+        }
+        auto indexed = nameIndex.find(std::string_view(newItem->getName()));
+        if (indexed != nameIndex.end()) {
+            for (uint32_t slot : indexed->second) {
+                uint32_t denseIndex = slots[slot].denseIndex;
+                if (sameItem(*(*storedItems)[denseIndex].item, *newItem)) {
+                    mutableItems()[denseIndex].count += count;
+                    totalItems += count;
+                    return ItemHandle{slot, slots[slot].generation};
+                }
+            }
+        }
+        
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{0, 0});
+        }
+        ItemList& items = mutableItems();
+        slots[slot].denseIndex = static_cast<uint32_t>(items.size());
+
+        if (indexed == nameIndex.end()) {
+            indexed = nameIndex.emplace(newItem->getName(), std::vector<uint32_t>()).first;
+        }
+        indexed->second.push_back(slot);
+
+        items.push_back(ItemStack{std::move(newItem), count});
+        denseSlots.push_back(slot);
+        totalItems += count;
+        return ItemHandle{slot, slots[slot].generation};
     }
     
-    void showCharacterStatus() const {
-        mainCharacter.displayCharacterInfo();
+    // Убирает count предметов из стопки. Место опустевшей стопки в плотном
+    // массиве занимает последняя, поэтому порядок стопок может меняться.
+    void removeFromStack(ItemHandle handle, uint32_t count) {
+        uint32_t denseIndex = slots[handle.slot].denseIndex;
+        ItemList& items = mutableItems();
+        totalItems -= count;
+        items[denseIndex].count -= count;
+        if (items[denseIndex].count > 0) return;
+
+        auto indexed = nameIndex.find(std::string_view(items[denseIndex].item->getName()));
+        auto& sameName = indexed->second;
+        *std::find(sameName.begin(), sameName.end(), handle.slot) = sameName.back();
+        sameName.pop_back();
+        if (sameName.empty()) nameIndex.erase(indexed);
+
+        uint32_t lastIndex = static_cast<uint32_t>(items.size() - 1);
+        if (denseIndex != lastIndex) {
+            items[denseIndex] = std::move(items[lastIndex]);
+            denseSlots[denseIndex] = denseSlots[lastIndex];
+            slots[denseSlots[denseIndex]].denseIndex = denseIndex;
+        }
+        items.pop_back();
+        denseSlots.pop_back();
+
+        ++slots[handle.slot].generation;
+        freeSlots.push_back(handle.slot);
+    }
+    
+public:
+    ItemStorage() = default;
+    
+    // Мьютекс не переносится: перенос берет мьютексы обоих хранилищ, а
+    // ссылки других потоков на старое хранилище остаются на пустое.
+    ItemStorage(ItemStorage&& other) {
+        *this = std::move(other);
+    }
+    
+    ItemStorage& operator=(ItemStorage&& other) {
+        if (this != &other) {
+            std::scoped_lock lock(storageMutex, other.storageMutex);
+            storedItems = std::exchange(other.storedItems, std::make_shared<ItemList>());
+            denseSlots = std::exchange(other.denseSlots, {});
+            slots = std::exchange(other.slots, {});
+            freeSlots = std::exchange(other.freeSlots, {});
+            nameIndex = std::exchange(other.nameIndex, {});
+            totalItems = std::exchange(other.totalItems, 0);
+            pinnedStack = std::exchange(other.pinnedStack, ItemHandle{});
+        }
+        return *this;
+    }
+    
+    ItemHandle addItem(std::unique_ptr<GameItem> newItem, uint32_t count = 1) {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        return addStack(std::move(newItem), count);
+    }
+    
+    // Закрепляет стопку: transfer не заберет ее последний предмет. Пустой
+    // дескриптор снимает закрепление. Возвращает false, если стопки уже нет.
+    bool pin(ItemHandle handle) {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        if (handle != ItemHandle{} && !stackAt(handle)) return false;
+        pinnedStack = handle;
+        return true;
+    }
+    
+    // Переносит count предметов с именем itemName из source в target как одну
+    // операцию: другие потоки видят оба хранилища либо до, либо после переноса.
+    // Мьютексы берутся в порядке адресов хранилищ, поэтому встречные переносы
+    // не блокируют друг друга навсегда. Закрепленную стопку можно отдать
+    // только частично. Возвращает ячейку, из которой взяты предметы; если
+    // стопка опустела, ссылка на нее больше недействительна.
+    static ItemHandle transfer(ItemStorage& source, ItemStorage& target, std::string_view itemName, uint32_t count) {
+        if (&source == &target) {
+            throw GameWorldException("Нельзя передать предметы самому себе");
+        }
+        if (count == 0) {
+            throw GameWorldException("Пустая стопка предметов");
+        }
+        bool sourceFirst = std::less<const ItemStorage*>()(&source, &target);
+        std::lock_guard<std::mutex> firstLock(sourceFirst ? source.storageMutex : target.storageMutex);
+        std::lock_guard<std::mutex> secondLock(sourceFirst ? target.storageMutex : source.storageMutex);
+        
+        ItemHandle handle = source.handleNamed(itemName);
+        ItemStack* stack = source.stackAt(handle);
+        if (!stack) {
+            throw GameWorldException("Предмет не найден в инвентаре");
+        }
+        if (stack->count < count) {
+            throw GameWorldException("Недостаточно предметов для передачи");
+        }
+        if (handle == source.pinnedStack && stack->count == count) {
+            throw GameWorldException("Надетое снаряжение нельзя отдать целиком");
+        }
+        
+        // Все выделения памяти у источника делаются до изменения получателя,
+        // чтобы нехватка памяти не оставила предметы в обоих хранилищах.
+        std::shared_ptr<GameItem> item = stack->item;
+        source.mutableItems();
+        source.freeSlots.reserve(source.freeSlots.size() + 1);
+        target.addStack(std::move(item), count);
+        source.removeFromStack(handle, count);
+        return handle;
+    }
+    
+    std::shared_ptr<GameItem> getItem(ItemHandle handle) const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        ItemStack* stack = stackAt(handle);
+        return stack ? stack->item : nullptr;
+    }
+
+    uint32_t countOf(ItemHandle handle) const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        ItemStack* stack = stackAt(handle);
+        return stack ? stack->count : 0;
+    }
+
+    ItemHandle findHandle(std::string_view itemName) const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        return handleNamed(itemName);
+    }
+
+    // Дескриптор стопки с именем и ее позиция на один и тот же момент.
+    std::pair<ItemHandle, uint32_t> locate(std::string_view itemName) const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        ItemHandle handle = handleNamed(itemName);
+        if (!stackAt(handle)) {
+            throw GameWorldException("Предмет не найден в инвентаре");
+        }
+        return {handle, slots[handle.slot].denseIndex};
+    }
+
+    std::shared_ptr<GameItem> findItem(std::string_view itemName) const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        ItemStack* stack = stackAt(handleNamed(itemName));
+        return stack ? stack->item : nullptr;
+    }
+
+    // Позиция стопки в плотном массиве; меняется при удалении других стопок.
+    uint32_t positionOf(ItemHandle handle) const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        if (!stackAt(handle)) {
+            throw GameWorldException("Предмет не найден в инвентаре");
+        }
+        return slots[handle.slot].denseIndex;
+    }
+
+    ItemHandle handleAt(uint32_t position) const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        if (position >= denseSlots.size()) return ItemHandle{};
+        uint32_t slot = denseSlots[position];
+        return ItemHandle{slot, slots[slot].generation};
+    }
+
+    // Убирает один предмет из стопки.
+    void removeItem(ItemHandle handle) {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        if (!stackAt(handle)) {
+            throw GameWorldException("Предмет не найден в инвентаре");
+        }
+        removeFromStack(handle, 1);
+    }
+
+    void removeItem(std::string_view itemToRemove) {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        ItemHandle handle = handleNamed(itemToRemove);
+        if (!stackAt(handle)) {
+            throw GameWorldException("Предмет не найден в инвентаре");
+        }
+        removeFromStack(handle, 1);
+    }
+
+    size_t itemCount() const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        return totalItems;
+    }
+    
+    size_t stackCount() const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        return storedItems->size();
+    }
+    
+    std::shared_ptr<const ItemList> snapshot() const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        return storedItems;
+    }
+    
+    PinnedSnapshot snapshotWithPin() const {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        uint32_t position = stackAt(pinnedStack) ? slots[pinnedStack.slot].denseIndex : NO_POSITION;
+        return PinnedSnapshot{storedItems, position};
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(storageMutex);
+        for (uint32_t slot : denseSlots) {
+            ++slots[slot].generation;
+            freeSlots.push_back(slot);
+        }
+        if (storedItems.use_count() > 1) {
+            storedItems = std::make_shared<ItemList>();
+        } else {
+            storedItems->clear();
+        }
+        denseSlots.clear();
+        nameIndex.clear();
+        totalItems = 0;
+    }
+    
+    void displayContents() const {
+        std::shared_ptr<const ItemList> items = snapshot();
+        if (items->empty()) {
+            std::cout << "Инвентарь пуст" << std::endl;
+            return;
+        }
+        
+        std::cout << "Содержимое инвентаря:" << std::endl;
+        for (const auto& stack : *items) {
+            std::cout << "• " << stack.item->getName() << ": " << stack.item->getDescription();
+            if (stack.count > 1) std::cout << " (" << stack.count << " шт.)";
+            std::cout << std::endl;
+        }
+    }
+    
+    void saveInventory(const std::string& storageFile) const {
+        saveInventory(storageFile, *snapshot());
+    }
+    
+    static void saveInventory(const std::string& storageFile, const ItemList& items) {
+        std::ofstream outputFile(storageFile);
+        if (!outputFile) {
+            throw GameWorldException("Ошибка сохранения инвентаря");
+        }
+        
+        for (const auto& stack : items) {
+            outputFile << stack.item->saveData() << "," << stack.count << "\n";
+        }
+    }
+    
+    void writeBinary(SaveWriter& writer) const {
+        writeBinary(writer, *snapshot());
+    }
+    
+    static void writeBinary(SaveWriter& writer, const ItemList& items) {
+        writer.put<uint32_t>(static_cast<uint32_t>(items.size()));
+        for (const auto& stack : items) {
+            const GameItem& item = *stack.item;
+            const ItemKindInfo& kind = itemKindTable[static_cast<size_t>(item.getKind())];
+            writer.put<uint8_t>(static_cast<uint8_t>(item.getKind()));
+            writer.putString(item.getName());
+            writer.putString(item.getDescription());
+            writer.put<int32_t>(kind.value(item));
+            writer.put<uint32_t>(stack.count);
+        }
+    }
+
+    void readBinary(SaveReader& reader, uint32_t version = SAVE_FORMAT_VERSION) {
+        clear();
+        uint32_t count = reader.get<uint32_t>();
+        for (uint32_t i = 0; i < count; ++i) {
+            uint8_t kind = reader.get<uint8_t>();
+            if (kind >= static_cast<uint8_t>(ItemKind::KindCount)) {
+                throw GameWorldException("Файл сохранения поврежден");
+            }
+            std::string_view name = reader.getStringView();
+            std::string_view description = reader.getStringView();
+            int value = reader.get<int32_t>();
+            // До версии 2 каждый предмет записывался отдельно, без количества.
+            uint32_t count = version >= 2 ? reader.get<uint32_t>() : 1;
+            if (count == 0) {
+                throw GameWorldException("Файл сохранения поврежден");
+            }
+            addItem(makeItem(static_cast<ItemKind>(kind), name, description, value), count);
+        }
+    }
+
+    void loadInventory(const std::string& storageFile) {
+        std::ifstream inputFile(storageFile);
+        if (!inputFile) {
+            throw GameWorldException("Ошибка загрузки инвентаря");
+        }
+        
+        clear();
+        forEachCsvRecord(inputFile, [this](std::string_view record, size_t lineNumber) {
+            CsvFieldReader fields(record, lineNumber);
+            std::string_view tag = fields.nextText();
+            if (fields.atEnd()) return;
+            
+            const ItemKindInfo* kind = findItemKind(tag);
+            if (!kind) return;
+            
+            std::string_view name = fields.nextText();
+            std::string_view description = fields.nextText();
+            int value = fields.nextInt();
+            // Количество появилось позже; в старых файлах его нет.
+            int count = fields.atEnd() ? 1 : fields.nextInt();
+            fields.expectEnd();
+            if (count <= 0) {
+                throw RecordParseError("количество предметов должно быть положительным", lineNumber, 1);
+            }
+            addItem(makeItem(kind->kind, name, description, value), static_cast<uint32_t>(count));
+        });
+    }
+};
+
+// Правила развития персонажа общие для игры и симулятора боев.
+constexpr int STARTING_HEALTH = 100;
+constexpr int STARTING_ATTACK = 10;
+constexpr int STARTING_DEFENSE = 5;
+constexpr int LEVEL_UP_EXPERIENCE = 100;
+constexpr int LEVEL_HEALTH_GAIN = 10;
+constexpr int LEVEL_ATTACK_GAIN = 2;
+constexpr int LEVEL_DEFENSE_GAIN = 1;
+constexpr int EXPERIENCE_PER_ATTACK = 5;
+
+// Имена существ, прочитанные из файлов, хранятся один раз на всю программу.
+inline const std::string& internCreatureName(std::string_view name) {
+    static std::mutex internMutex;
+    static std::deque<std::string> knownNames;
+    
+    std::lock_guard<std::mutex> lock(internMutex);
+    for (const auto& known : knownNames) {
+        if (known == name) return known;
+    }
+    return knownNames.emplace_back(name);
+}
+
+enum class CreatureSpecies : uint8_t {
+    ForestGoblin,
+    AncientDragon,
+    UndeadWarrior,
+    SpeciesCount
+};
+
+// Существо хранит указатель на имя из internCreatureName, поэтому имя
+// не зависит от строки, переданной в конструктор, а копия существа не
+// выделяет память.
+class GameCreature {
+protected:
+    const std::string* creatureName;
+    int hitPoints;
+    int attackPower;
+    int defenseValue;
+    
+public:
+    GameCreature(std::string_view name, int hp, int atk, int def)
+        : creatureName(&internCreatureName(name)), hitPoints(hp), attackPower(atk), defenseValue(def) {}
+        
+    virtual ~GameCreature() {}
+    
+    virtual void performAttack(class GameCharacter& target) = 0;
+    virtual int damageAgainst(int targetDefense) const = 0;
+    virtual CreatureSpecies getSpecies() const = 0;
+    
+    bool isAlive() const { return hitPoints > 0; }
+    
+    void receiveDamage(int damage) {
+        hitPoints -= damage;
+        if (hitPoints < 0) hitPoints = 0;
+    }
+    
+    virtual std::string saveCreatureData() const {
+        std::string record;
+        appendCsvField(record, *creatureName);
+        record += "," + std::to_string(hitPoints) + "," + 
+                  std::to_string(attackPower) + "," + std::to_string(defenseValue);
+        return record;
+    }
+    
+    virtual void loadCreatureData(std::string_view creatureData, size_t lineNumber = 1) {
+        CsvFieldReader fields(creatureData, lineNumber);
+        std::string_view name = fields.nextText();
+        int hp = fields.nextInt();
+        int atk = fields.nextInt();
+        int def = fields.nextInt();
+        fields.expectEnd();
+        
+        creatureName = &internCreatureName(name);
+        hitPoints = hp;
+        attackPower = atk;
+        defenseValue = def;
+    }
+    
+    virtual void displayCreatureInfo() const {
+        std::cout << *creatureName << " - Здоровье: " << hitPoints 
+                  << ", Атака: " << attackPower << ", Защита: " << defenseValue;
+    }
+    
+    const std::string& getName() const { return *creatureName; }
+    int getHealth() const { return hitPoints; }
+    int getAttack() const { return attackPower; }
+    int getDefense() const { return defenseValue; }
+};
+
+// Описания видов существ. Новый вид добавляется значением CreatureSpecies
+// и строкой таблицы; порядок строк проверяется при компиляции.
+struct CreatureDefinition {
+    CreatureSpecies species;
+    std::string_view savedTag;
+    std::string_view name;
+    int health;
+    int attack;
+    int defense;
+    std::string_view attackText;
+};
+
+constexpr CreatureDefinition creatureTable[] = {
+    {CreatureSpecies::ForestGoblin, "Гоблин", "Лесной гоблин", 30, 8, 3, "Гоблин атакует своим дубинкой!"},
+    {CreatureSpecies::AncientDragon, "Дракон", "Древний дракон", 100, 20, 10, "Дракон извергает пламя!"},
+    {CreatureSpecies::UndeadWarrior, "Нежить", "Нежить-воин", 40, 10, 5, "Нежить атакует ржавым мечом!"},
+};
+
+constexpr bool creatureTableMatchesEnum() {
+    if (std::size(creatureTable) != static_cast<size_t>(CreatureSpecies::SpeciesCount)) return false;
+    for (size_t i = 0; i < std::size(creatureTable); ++i) {
+        if (static_cast<size_t>(creatureTable[i].species) != i) return false;
+    }
+    return true;
+}
+
+static_assert(creatureTableMatchesEnum(), "creatureTable должна перечислять CreatureSpecies по порядку");
+
+constexpr const CreatureDefinition& creatureDefinition(CreatureSpecies species) {
+    return creatureTable[static_cast<size_t>(species)];
+}
+
+// Общая реализация существа по строке таблицы. Derived::species выбирает
+// строку при компиляции, поэтому расчет урона встраивается, а имя вида
+// хранится в одной статической строке на вид.
+template<typename Derived>
+class CreatureBase : public GameCreature {
+public:
+    static constexpr const CreatureDefinition& definition() { return creatureDefinition(Derived::species); }
+    
+    static inline const std::string speciesName{definition().name};
+    
+    CreatureBase() : GameCreature(speciesName, definition().health, definition().attack, definition().defense) {}
+    
+    int damageAgainst(int targetDefense) const override {
+        int damage = attackPower - targetDefense;
+        return damage > 0 ? damage : 0;
+    }
+    
+    CreatureSpecies getSpecies() const override { return Derived::species; }
+    
+    void performAttack(GameCharacter& target) override;
+    
+    std::string saveCreatureData() const override {
+        return std::string(definition().savedTag) + "," + GameCreature::saveCreatureData();
+    }
+};
+
+template<CreatureSpecies Species>
+class TableCreature final : public CreatureBase<TableCreature<Species>> {
+public:
+    static constexpr CreatureSpecies species = Species;
+};
+
+using ForestGoblin = TableCreature<CreatureSpecies::ForestGoblin>;
+using AncientDragon = TableCreature<CreatureSpecies::AncientDragon>;
+using UndeadWarrior = TableCreature<CreatureSpecies::UndeadWarrior>;
+
+// Снимок персонажа для сохранения в фоне: характеристики копируются,
+// а инвентарь разделяется со снимком ItemStorage.
+struct CharacterSnapshot {
+    std::string name;
+    std::array<int32_t, 6> stats;
+    std::shared_ptr<const ItemStorage::ItemList> items;
+    uint32_t equippedPosition;
+};
+
+constexpr uint32_t NOTHING_EQUIPPED = ItemStorage::NO_POSITION;
+
+// Характеристики, на которые действуют уровень, снаряжение и эффекты.
+enum class CharacterStat : uint8_t {
+    MaxHealth,
+    Attack,
+    Defense,
+    StatCount
+};
+
+// Временный эффект: прибавка к одной характеристике.
+struct StatModifier {
+    CharacterStat stat;
+    int amount;
+};
+
+// Базовые характеристики меняются только с уровнем. Итоговые значения
+// (база + снаряжение + эффекты) хранятся в кэше и пересчитываются при
+// первом чтении после изменения: каждое изменение помечает только те
+// характеристики, которые затрагивает, а бой читает готовые числа.
+class GameCharacter {
+private:
+    static constexpr size_t STAT_COUNT = static_cast<size_t>(CharacterStat::StatCount);
+    static constexpr uint8_t ALL_STATS = (1u << STAT_COUNT) - 1;
+    
+    std::string characterName;
+    int currentHealth;
+    std::array<int, STAT_COUNT> baseStats;
+    int characterLevel;
+    int experiencePoints;
+    ItemStorage characterInventory;
+    ItemHandle equippedGear;
+    std::vector<StatModifier> activeBuffs;
+    mutable std::array<int, STAT_COUNT> effectiveStats{};
+    mutable uint8_t dirtyStats = ALL_STATS;
+    
+    void invalidate(CharacterStat stat) {
+        dirtyStats |= static_cast<uint8_t>(1u << static_cast<size_t>(stat));
+    }
+    
+    // Надетая стопка закреплена в инвентаре, поэтому giveItem из других
+    // потоков не может отдать ее целиком и не трогает equippedGear.
+    bool setEquippedGear(ItemHandle handle) {
+        if (!characterInventory.pin(handle)) return false;
+        equippedGear = handle;
+        invalidate(CharacterStat::Attack);
+        return true;
+    }
+    
+    int recompute(CharacterStat stat) const {
+        int value = baseStats[static_cast<size_t>(stat)];
+        if (stat == CharacterStat::Attack) {
+            if (auto gear = std::static_pointer_cast<const CombatGear>(characterInventory.getItem(equippedGear))) {
+                value += gear->getDamageBonus();
+            }
+        }
+        for (const auto& buff : activeBuffs) {
+            if (buff.stat == stat) value += buff.amount;
+        }
+        return value;
+    }
+    
+    int effective(CharacterStat stat) const {
+        size_t index = static_cast<size_t>(stat);
+        if (dirtyStats & (1u << index)) {
+            effectiveStats[index] = recompute(stat);
+            dirtyStats &= static_cast<uint8_t>(~(1u << index));
+        }
+        return effectiveStats[index];
+    }
+    
+public:
+    GameCharacter(const std::string& name, int health, int attack, int defense)
+        : characterName(name), currentHealth(health), baseStats{health, attack, defense},
+          characterLevel(1), experiencePoints(0) {}
+        
+    void attackTarget(GameCreature& enemy) {
+        int damageDealt = getAttack() - enemy.getDefense();
+        if (damageDealt > 0) {
+            enemy.receiveDamage(damageDealt);
+            std::cout << characterName << " атакует " << enemy.getName() << " и наносит " << damageDealt << " урона!" << std::endl;
+        } else {
+            std::cout << characterName << " атакует " << enemy.getName() << ", но атака неэффективна!" << std::endl;
+        }
+    }
+    
+    void receiveDamage(int damageTaken) {
+        currentHealth -= damageTaken;
+        if (currentHealth < 0) {
+            currentHealth = 0;
+            throw GameWorldException(characterName + " повержен!");
+        }
+    }
+    
+    void restoreHealth(int healAmount) {
+        currentHealth += healAmount;
+        if (currentHealth > getMaxHealth()) currentHealth = getMaxHealth();
+        std::cout << characterName << " восстанавливает " << healAmount << " здоровья!" << std::endl;
+    }
+    
+    void gainExperience(int expGained) {
+        experiencePoints += expGained;
+        if (experiencePoints >= LEVEL_UP_EXPERIENCE) {
+            characterLevel++;
+            experiencePoints -= LEVEL_UP_EXPERIENCE;
+            baseStats[static_cast<size_t>(CharacterStat::MaxHealth)] += LEVEL_HEALTH_GAIN;
+            baseStats[static_cast<size_t>(CharacterStat::Attack)] += LEVEL_ATTACK_GAIN;
+            baseStats[static_cast<size_t>(CharacterStat::Defense)] += LEVEL_DEFENSE_GAIN;
+            dirtyStats = ALL_STATS;
+            currentHealth = getMaxHealth();
+            std::cout << characterName << " достиг уровня " << characterLevel << "!" << std::endl;
+        }
+    }
+    
+    // Возвращает позицию предмета в инвентаре до использования.
+    uint32_t useInventoryItem(const std::string& itemName) {
+        auto [handle, position] = characterInventory.locate(itemName);
+        useItem(handle);
+        return position;
+    }
+    
+    void useInventoryItemAt(uint32_t position) {
+        useItem(characterInventory.handleAt(position));
+    }
+    
+private:
+    void useItem(ItemHandle handle) {
+        std::shared_ptr<GameItem> item = characterInventory.getItem(handle);
+        if (!item) {
+            throw GameWorldException("Предмет не найден в инвентаре");
+        }
+        
+        switch (item->getKind()) {
+            case ItemKind::HealingItem: {
+                auto healingItem = static_cast<HealingItem*>(item.get());
+                characterInventory.removeItem(handle);
+                restoreHealth(healingItem->getHealAmount());
+                break;
+            }
+            case ItemKind::CombatGear: {
+                // Снаряжение не складывается: повторное использование снимает его.
+                if (equippedGear == handle) {
+                    unequipGear();
+                    std::cout << "Снято " << item->getName() << std::endl;
+                    break;
+                }
+                auto weaponItem = static_cast<CombatGear*>(item.get());
+                if (!setEquippedGear(handle)) {
+                    throw GameWorldException("Предмет не найден в инвентаре");
+                }
+                std::cout << "Экипировано " << weaponItem->getName() << "! Бонус к атаке: " 
+                          << weaponItem->getDamageBonus() << std::endl;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    
+public:
+    void unequipGear() {
+        setEquippedGear(ItemHandle{});
+    }
+    
+    std::shared_ptr<const GameItem> getEquippedGear() const {
+        return characterInventory.getItem(equippedGear);
+    }
+    
+    void addBuff(StatModifier buff) {
+        activeBuffs.push_back(buff);
+        invalidate(buff.stat);
+    }
+    
+    void clearBuffs() {
+        for (const auto& buff : activeBuffs) invalidate(buff.stat);
+        activeBuffs.clear();
+        if (currentHealth > getMaxHealth()) currentHealth = getMaxHealth();
+    }
+    
+public:
+    void displayCharacterInfo() const {
+        std::cout << "Имя: " << characterName << ", Здоровье: " << currentHealth << "/" << getMaxHealth()
+                  << ", Атака: " << getAttack() << ", Защита: " << getDefense()
+                  << ", Уровень: " << characterLevel << ", Опыт: " << experiencePoints << "/" << LEVEL_UP_EXPERIENCE << std::endl;
+    }
+    
+    void saveCharacterProgress(const std::string& saveFile) const {
+        std::ofstream outputFile(saveFile);
+        if (!outputFile) {
+            throw GameWorldException("Ошибка сохранения персонажа");
+        }
+        
+        outputFile << characterName << "\n";
+        outputFile << currentHealth << "\n";
+        for (int stat : baseStats) {
+            outputFile << stat << "\n";
+        }
+        outputFile << characterLevel << "\n";
+        outputFile << experiencePoints << "\n";
+        // Надетая стопка закреплена в инвентаре, поэтому ее позиция берется
+        // вместе со списком стопок под одной блокировкой.
+        ItemStorage::PinnedSnapshot inventory = characterInventory.snapshotWithPin();
+        uint32_t equipped = inventory.pinnedPosition;
+        outputFile << (equipped == NOTHING_EQUIPPED ? -1 : static_cast<int64_t>(equipped)) << "\n";
+        
+        ItemStorage::saveInventory(saveFile + "_инвентарь", *inventory.items);
+    }
+    
+    void loadCharacterProgress(const std::string& saveFile) {
+        std::ifstream inputFile(saveFile);
+        if (!inputFile) {
+            throw GameWorldException("Ошибка загрузки персонажа");
+        }
+        
+        std::getline(inputFile, characterName);
+        
+        std::string dataLine;
+        std::getline(inputFile, dataLine); currentHealth = std::stoi(dataLine);
+        for (int& stat : baseStats) {
+            std::getline(inputFile, dataLine); stat = std::stoi(dataLine);
+        }
+        std::getline(inputFile, dataLine); characterLevel = std::stoi(dataLine);
+        std::getline(inputFile, dataLine); experiencePoints = std::stoi(dataLine);
+        // Строки со снаряжением в старых файлах нет.
+        int64_t equipped = -1;
+        if (std::getline(inputFile, dataLine)) equipped = std::stoll(dataLine);
+        
+        characterInventory.loadInventory(saveFile + "_инвентарь");
+        // Текстовые файлы правят вручную: позиция не снаряжения снимает снаряжение.
+        setEquippedGear(equipped >= 0 ? gearAt(characterInventory, static_cast<uint32_t>(equipped)) : ItemHandle{});
+        activeBuffs.clear();
+        dirtyStats = ALL_STATS;
+    }
+    
+    // Дескриптор снаряжения на позиции; пустой, если там нет CombatGear.
+    static ItemHandle gearAt(const ItemStorage& inventory, uint32_t position) {
+        ItemHandle handle = inventory.handleAt(position);
+        std::shared_ptr<GameItem> item = inventory.getItem(handle);
+        return item && item->getKind() == ItemKind::CombatGear ? handle : ItemHandle{};
+    }
+    
+    CharacterSnapshot snapshot() const {
+        ItemStorage::PinnedSnapshot inventory = characterInventory.snapshotWithPin();
+        return CharacterSnapshot{
+            characterName,
+            {currentHealth, baseStats[0], baseStats[1], baseStats[2], characterLevel, experiencePoints},
+            std::move(inventory.items),
+            inventory.pinnedPosition
+        };
+    }
+    
+    static void writeSnapshot(const CharacterSnapshot& state, SaveWriter& writer) {
+        writer.putString(state.name);
+        for (int32_t value : state.stats) {
+            writer.put<int32_t>(value);
+        }
+        ItemStorage::writeBinary(writer, *state.items);
+        writer.put<uint32_t>(state.equippedPosition);
+    }
+    
+    void saveCharacterBinary(const std::string& saveFile) const {
+        SaveWriter writer;
+        writeSnapshot(snapshot(), writer);
+        writeSaveFile(saveFile, writer);
+    }
+    
+    // Состояние меняется только после того, как весь файл прочитан без ошибок.
+    void loadCharacterBinary(const std::string& saveFile) {
+        MappedSaveFile mapped(saveFile);
+        SaveReader reader(mapped.payload(), mapped.payloadSize());
+        readBinary(reader, mapped.version());
+    }
+    
+    // Читает снимок из writeSnapshot; буфер должен содержать ровно один снимок.
+    // До версии 3 надетое снаряжение не сохранялось, а его бонус уже входил в
+    // атаку, поэтому такая атака становится базовой и ничего не надето.
+    void readBinary(SaveReader& reader, uint32_t version = SAVE_FORMAT_VERSION) {
+        std::string name = reader.getString();
+        int32_t stats[6];
+        for (auto& stat : stats) stat = reader.get<int32_t>();
+        ItemStorage inventory;
+        inventory.readBinary(reader, version);
+        uint32_t equipped = version >= 3 ? reader.get<uint32_t>() : NOTHING_EQUIPPED;
+        ItemHandle gear = equipped == NOTHING_EQUIPPED ? ItemHandle{} : gearAt(inventory, equipped);
+        if (!reader.finished() || (equipped != NOTHING_EQUIPPED && !inventory.getItem(gear))) {
+            throw GameWorldException("Файл сохранения поврежден");
+        }
+        
+        characterName = std::move(name);
+        currentHealth = stats[0];
+        baseStats = {stats[1], stats[2], stats[3]};
+        characterLevel = stats[4];
+        experiencePoints = stats[5];
+        characterInventory = std::move(inventory);
+        setEquippedGear(gear);
+        activeBuffs.clear();
+        dirtyStats = ALL_STATS;
+    }
+    
+    void addItemToInventory(std::unique_ptr<GameItem> newItem) {
+        characterInventory.addItem(std::move(newItem));
+    }
+    
+    // Передача предметов другому персонажу; можно вызывать из рабочих
+    // потоков. Меняются только инвентари под мьютексами ItemStorage::transfer:
+    // надетую стопку он целиком не отдает, поэтому снаряжение и кэш
+    // характеристик отдающего остаются за потоком-владельцем.
+    void giveItem(GameCharacter& receiver, std::string_view itemName, uint32_t count = 1) {
+        ItemStorage::transfer(characterInventory, receiver.characterInventory, itemName, count);
+    }
+    
+    void showCharacterInventory() const {
+        characterInventory.displayContents();
+    }
+    
+    size_t inventoryItemCount() const { return characterInventory.itemCount(); }
+    
+    std::string getName() const { return characterName; }
+    int getHealth() const { return currentHealth; }
+    int getMaxHealth() const { return effective(CharacterStat::MaxHealth); }
+    int getAttack() const { return effective(CharacterStat::Attack); }
+    int getDefense() const { return effective(CharacterStat::Defense); }
+    int getBaseStat(CharacterStat stat) const { return baseStats[static_cast<size_t>(stat)]; }
+    int getLevel() const { return characterLevel; }
+    int getExperience() const { return experiencePoints; }
+};
+
+template<typename Derived>
+void CreatureBase<Derived>::performAttack(GameCharacter& target) {
+    std::cout << definition().attackText << std::endl;
+    int damageDealt = damageAgainst(target.getDefense());
+    if (damageDealt > 0) {
+        target.receiveDamage(damageDealt);
+        std::cout << "Нанесено " << damageDealt << " урона!" << std::endl;
+    } else {
+        std::cout << "Атака не пробила защиту!" << std::endl;
+    }
+}
+
+// Сохранение в фоне: игровой поток только снимает снимок, а сериализация
+// и запись файла идут в рабочем потоке. Запросы к одному файлу, пришедшие
+// во время записи, сливаются: на диск попадает последний снимок.
+class AutosaveWorker {
+private:
+    struct PendingSave {
+        std::string saveFile;
+        CharacterSnapshot state;
+    };
+    
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::vector<PendingSave> pending;
+    std::vector<CharacterSnapshot> retired;
+    bool writing = false;
+    bool stopping = false;
+    uint64_t requestCount = 0;
+    uint64_t writtenCount = 0;
+    uint64_t coalescedCount = 0;
+    std::vector<std::string> failures;
+    std::thread worker;
+    
+    uint64_t pauseCount = 0;
+    double pauseTotalMicros = 0;
+    double pauseMaxMicros = 0;
+    
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        while (true) {
+            queueChanged.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            
+            PendingSave next = std::move(pending.front());
+            pending.erase(pending.begin());
+            std::vector<CharacterSnapshot> replaced = std::exchange(retired, {});
+            writing = true;
+            lock.unlock();
+            replaced.clear();
+            
+            std::string failure;
+            try {
+                SaveWriter writer;
+                GameCharacter::writeSnapshot(next.state, writer);
+                writeSaveFile(next.saveFile, writer);
+            } catch (const GameWorldException& error) {
+                failure = error.what();
+            }
+            
+            lock.lock();
+            writing = false;
+            ++writtenCount;
+            if (!failure.empty()) failures.push_back(std::move(failure));
+            queueChanged.notify_all();
+        }
+    }
+    
+public:
+    AutosaveWorker() : worker(&AutosaveWorker::workerLoop, this) {}
+    
+    ~AutosaveWorker() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueChanged.notify_all();
+        worker.join();
+    }
+    
+    AutosaveWorker(const AutosaveWorker&) = delete;
+    AutosaveWorker& operator=(const AutosaveWorker&) = delete;
+    
+    // Вызывается игровым потоком на границе хода; время снимка и постановки
+    // в очередь учитывается как пауза игрового цикла.
+    void request(const GameCharacter& character, const std::string& saveFile) {
+        auto started = std::chrono::steady_clock::now();
+        CharacterSnapshot state = character.snapshot();
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            ++requestCount;
+            auto queued = std::find_if(pending.begin(), pending.end(),
+                                       [&](const PendingSave& save) { return save.saveFile == saveFile; });
+            if (queued != pending.end()) {
+                // Вытесненный снимок освобождает рабочий поток
+                retired.push_back(std::exchange(queued->state, std::move(state)));
+                ++coalescedCount;
+            } else {
+                pending.push_back(PendingSave{saveFile, std::move(state)});
+            }
+        }
+        queueChanged.notify_one();
+        
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+        ++pauseCount;
+        pauseTotalMicros += micros;
+        pauseMaxMicros = std::max(pauseMaxMicros, micros);
+    }
+    
+    // Ждет, пока все поставленные сохранения будут записаны.
+    void flush() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueChanged.wait(lock, [this]() { return pending.empty() && !writing; });
+    }
+    
+    std::vector<std::string> takeFailures() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return std::exchange(failures, {});
+    }
+    
+    void report(std::ostream& output) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        output << "Сохранений запрошено: " << requestCount << ", записано: " << writtenCount
+               << ", слито: " << coalescedCount << "\n";
+        if (pauseCount > 0) {
+            output << "Пауза игрового цикла: средняя " << pauseTotalMicros / pauseCount
+                   << " мкс, максимальная " << pauseMaxMicros << " мкс\n";
+        }
+    }
+};
+
+// Счетчик выделений памяти для отчетов о пулах. Глобальный operator new
+// со счетчиком подменяется только в сборке для замеров с
+// -DCOUNT_HEAP_ALLOCATIONS: иначе все потоки игры били бы в одну атомарную
+// переменную, и счетчик остается нулевым.
+std::atomic<uint64_t> heapAllocations{0};
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// Встраивание запрещено: иначе GCC видит пару malloc/free внутри new/delete
+// и выдает ложное предупреждение о несовпадающих функциях.
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* memory) noexcept { std::free(memory); }
+[[gnu::noinline]] void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+#endif
+
+void reportHeapCounting(std::ostream& output) {
+#ifndef COUNT_HEAP_ALLOCATIONS
+    output << "Выделения памяти не считаются: соберите с -DCOUNT_HEAP_ALLOCATIONS\n";
+#else
+    (void)output;
+#endif
+}
+
+class CreaturePoolBase {
+public:
+    virtual ~CreaturePoolBase() {}
+    virtual GameCreature* acquire() = 0;
+    virtual void release(GameCreature* creature) = 0;
+    virtual GameCreature& prototype() = 0;
+};
+
+// Пул существ одного вида. Память берется блоками, освобожденные места
+// уходят в список свободных, а новое существо копируется из прототипа.
+// Пул не потокобезопасен: существа создаются игровым потоком.
+template<typename Creature>
+class CreaturePool : public CreaturePoolBase {
+private:
+    union Slot {
+        Slot* nextFree;
+        alignas(Creature) unsigned char storage[sizeof(Creature)];
+    };
+    
+    static constexpr size_t SLOTS_PER_BLOCK = 64;
+    
+    Creature creaturePrototype;
+    std::vector<std::unique_ptr<Slot[]>> blocks;
+    Slot* freeList = nullptr;
+    
+    void grow() {
+        blocks.push_back(std::make_unique<Slot[]>(SLOTS_PER_BLOCK));
+        Slot* block = blocks.back().get();
+        for (size_t i = 0; i < SLOTS_PER_BLOCK; ++i) {
+            block[i].nextFree = freeList;
+            freeList = &block[i];
+        }
+    }
+    
+public:
+    GameCreature* acquire() override {
+        if (!freeList) grow();
+        Slot* slot = freeList;
+        freeList = slot->nextFree;
+        return new (slot->storage) Creature(creaturePrototype);
+    }
+    
+    void release(GameCreature* creature) override {
+        Creature* derived = static_cast<Creature*>(creature);
+        derived->~Creature();
+        Slot* slot = reinterpret_cast<Slot*>(derived);
+        slot->nextFree = freeList;
+        freeList = slot;
+    }
+    
+    GameCreature& prototype() override { return creaturePrototype; }
+    
+    size_t capacity() const { return blocks.size() * SLOTS_PER_BLOCK; }
+};
+
+struct PooledCreatureDeleter {
+    CreaturePoolBase* pool;
+    
+    void operator()(GameCreature* creature) const {
+        pool->release(creature);
+    }
+};
+
+using PooledCreature = std::unique_ptr<GameCreature, PooledCreatureDeleter>;
+
+// Пулы для всех видов из creatureTable.
+template<typename Sequence>
+struct SpeciesPools;
+
+template<size_t... Index>
+struct SpeciesPools<std::index_sequence<Index...>> {
+    using type = std::tuple<CreaturePool<TableCreature<static_cast<CreatureSpecies>(Index)>>...>;
+};
+
+// Создает существ по виду. Прототип вида можно изменить (например,
+// загрузить из файла), и следующие существа будут его копиями.
+class CreatureFactory {
+private:
+    static constexpr size_t SPECIES_COUNT = static_cast<size_t>(CreatureSpecies::SpeciesCount);
+    
+    SpeciesPools<std::make_index_sequence<SPECIES_COUNT>>::type speciesPools;
+    std::array<CreaturePoolBase*, SPECIES_COUNT> pools;
+    std::array<uint64_t, SPECIES_COUNT> spawned{};
+    
+public:
+    CreatureFactory()
+        : pools(std::apply([](auto&... pool) { return std::array<CreaturePoolBase*, SPECIES_COUNT>{&pool...}; }, speciesPools)) {}
+    
+    CreatureFactory(const CreatureFactory&) = delete;
+    CreatureFactory& operator=(const CreatureFactory&) = delete;
+    
+    PooledCreature spawn(CreatureSpecies species) {
+        size_t index = static_cast<size_t>(species);
+        ++spawned[index];
+        return PooledCreature(pools[index]->acquire(), PooledCreatureDeleter{pools[index]});
+    }
+    
+    GameCreature& prototype(CreatureSpecies species) {
+        return pools[static_cast<size_t>(species)]->prototype();
+    }
+    
+    uint64_t spawnCount(CreatureSpecies species) const {
+        return spawned[static_cast<size_t>(species)];
+    }
+};
+
+enum class CombatOutcome : uint8_t {
+    PlayerWon,
+    PlayerDefeated,
+    Stalemate
+};
+
+// Версия записи боя своя. В версиях 1-3 заголовок нес общую с сохранениями
+// версию, и по ней читается снимок персонажа; с версии 4 версия снимка
+// хранится в самой записи, поэтому новые сохранения не ломают старые записи.
+constexpr uint32_t REPLAY_MAGIC = 0x504C5052;
+constexpr uint32_t REPLAY_FORMAT_VERSION = 4;
+constexpr uint32_t OLDEST_REPLAY_FORMAT_VERSION = 1;
+
+// Выбор игрока в записи: 0 — атака, n + 1 — предмет на позиции n в инвентаре.
+constexpr uint64_t REPLAY_ATTACK = 0;
+
+// Запись боя: зерно, противник, снимок персонажа на начало боя и выборы
+// игрока по одному varint на ход. Записываются только выполненные ходы,
+// поэтому повтор проходит тот же бой без ввода. Итог боя хранится, чтобы
+// повтор мог проверить, что правила не изменились.
+struct CombatReplay {
+    uint64_t seed = 0;
+    CreatureSpecies enemySpecies = CreatureSpecies::ForestGoblin;
+    int enemyHealth = 0;
+    std::vector<uint8_t> startingCharacter;
+    uint32_t characterVersion = SAVE_FORMAT_VERSION;
+    SaveWriter choices;
+    uint32_t turns = 0;
+    CombatOutcome outcome = CombatOutcome::Stalemate;
+    int finalPlayerHealth = 0;
+    int finalEnemyHealth = 0;
+    
+    void begin(uint64_t combatSeed, const GameCharacter& player, const GameCreature& enemy) {
+        seed = combatSeed;
+        enemySpecies = enemy.getSpecies();
+        enemyHealth = enemy.getHealth();
+        SaveWriter character;
+        GameCharacter::writeSnapshot(player.snapshot(), character);
+        startingCharacter = character.data();
+        characterVersion = SAVE_FORMAT_VERSION;
+        choices = SaveWriter();
+        turns = 0;
+    }
+    
+    void recordAttack() {
+        choices.putVarint(REPLAY_ATTACK);
+        ++turns;
+    }
+    
+    void recordItem(uint32_t position) {
+        choices.putVarint(static_cast<uint64_t>(position) + 1);
+        ++turns;
+    }
+    
+    void finish(CombatOutcome result, const GameCharacter& player, const GameCreature& enemy) {
+        outcome = result;
+        finalPlayerHealth = player.getHealth();
+        finalEnemyHealth = enemy.getHealth();
+    }
+    
+    void save(const std::string& replayFile) const {
+        SaveWriter writer;
+        writer.putVarint(seed);
+        writer.put<uint8_t>(static_cast<uint8_t>(enemySpecies));
+        writer.putVarint(static_cast<uint64_t>(enemyHealth));
+        writer.putVarint(characterVersion);
+        writer.putString(std::string_view(reinterpret_cast<const char*>(startingCharacter.data()), startingCharacter.size()));
+        writer.putVarint(turns);
+        writer.putString(std::string_view(reinterpret_cast<const char*>(choices.data().data()), choices.data().size()));
+        writer.put<uint8_t>(static_cast<uint8_t>(outcome));
+        writer.putVarint(static_cast<uint64_t>(finalPlayerHealth));
+        writer.putVarint(static_cast<uint64_t>(finalEnemyHealth));
+        writeSaveFile(replayFile, writer, REPLAY_MAGIC, REPLAY_FORMAT_VERSION);
+    }
+    
+    static CombatReplay load(const std::string& replayFile) {
+        MappedSaveFile mapped(replayFile, REPLAY_MAGIC, REPLAY_FORMAT_VERSION, OLDEST_REPLAY_FORMAT_VERSION);
+        SaveReader reader(mapped.payload(), mapped.payloadSize());
+        CombatReplay replay;
+        replay.seed = reader.getVarint();
+        uint8_t species = reader.get<uint8_t>();
+        if (species >= static_cast<uint8_t>(CreatureSpecies::SpeciesCount)) {
+            throw GameWorldException("Файл сохранения поврежден");
+        }
+        replay.enemySpecies = static_cast<CreatureSpecies>(species);
+        replay.enemyHealth = static_cast<int>(reader.getVarint());
+        uint64_t characterVersion = mapped.version() >= 4 ? reader.getVarint() : mapped.version();
+        if (characterVersion < OLDEST_SAVE_FORMAT_VERSION || characterVersion > SAVE_FORMAT_VERSION) {
+            throw GameWorldException("Неподдерживаемая версия сохранения: " + std::to_string(characterVersion));
+        }
+        replay.characterVersion = static_cast<uint32_t>(characterVersion);
+        std::string_view character = reader.getStringView();
+        replay.startingCharacter.assign(character.begin(), character.end());
+        replay.turns = static_cast<uint32_t>(reader.getVarint());
+        replay.choices.putBytes(reader.getStringView());
+        uint8_t outcome = reader.get<uint8_t>();
+        if (outcome > static_cast<uint8_t>(CombatOutcome::Stalemate)) {
+            throw GameWorldException("Файл сохранения поврежден");
+        }
+        replay.outcome = static_cast<CombatOutcome>(outcome);
+        replay.finalPlayerHealth = static_cast<int>(reader.getVarint());
+        replay.finalEnemyHealth = static_cast<int>(reader.getVarint());
+        if (!reader.finished()) {
+            throw GameWorldException("Файл сохранения поврежден");
+        }
+        return replay;
+    }
+};
+
+// Пока объект жив, поток вывода находится в состоянии ошибки, и операторы
+// вывода возвращаются сразу, не форматируя текст.
+class SilencedOutput {
+private:
+    std::ostream& stream;
+    std::ios::iostate previousState;
+    
+public:
+    explicit SilencedOutput(std::ostream& output) : stream(output), previousState(output.rdstate()) {
+        stream.setstate(std::ios::badbit);
+    }
+    
+    SilencedOutput(const SilencedOutput&) = delete;
+    SilencedOutput& operator=(const SilencedOutput&) = delete;
+    
+    ~SilencedOutput() { stream.clear(previousState); }
+};
+
+struct ReplayResult {
+    CombatOutcome outcome;
+    int playerHealth;
+    int enemyHealth;
+    uint32_t turns;
+    
+    bool matches(const CombatReplay& replay) const {
+        return outcome == replay.outcome && playerHealth == replay.finalPlayerHealth &&
+               enemyHealth == replay.finalEnemyHealth && turns == replay.turns;
+    }
+};
+
+// Повтор боя по записи с правилами initiateCombat, без ввода и без рассказа о бое.
+class CombatReplayer {
+private:
+    CreatureFactory creatureFactory;
+    
+public:
+    ReplayResult run(const CombatReplay& replay) {
+        SilencedOutput quiet(std::cout);
+        
+        GameCharacter player("", 0, 0, 0);
+        SaveReader character(replay.startingCharacter.data(), replay.startingCharacter.size());
+        player.readBinary(character, replay.characterVersion);
+        PooledCreature enemy = creatureFactory.spawn(replay.enemySpecies);
+        enemy->receiveDamage(enemy->getHealth() - replay.enemyHealth);
+        
+        SaveReader choices(replay.choices.data().data(), replay.choices.data().size());
+        ReplayResult result{CombatOutcome::PlayerDefeated, 0, 0, 0};
+        try {
+            while (player.getHealth() > 0 && enemy->isAlive() && result.turns < replay.turns) {
+                uint64_t choice = choices.getVarint();
+                if (choice == REPLAY_ATTACK) {
+                    player.attackTarget(*enemy);
+                } else {
+                    player.useInventoryItemAt(static_cast<uint32_t>(choice - 1));
+                }
+                ++result.turns;
+                
+                if (!enemy->isAlive()) {
+                    player.gainExperience(enemy->getAttack() * EXPERIENCE_PER_ATTACK);
+                    result.outcome = CombatOutcome::PlayerWon;
+                    break;
+                }
+                enemy->performAttack(player);
+            }
+            if (result.outcome != CombatOutcome::PlayerWon && player.getHealth() > 0) {
+                result.outcome = CombatOutcome::Stalemate;
+            }
+        } catch (const GameWorldException&) {
+            if (player.getHealth() > 0) throw;
+        }
+        result.playerHealth = player.getHealth();
+        result.enemyHealth = enemy->getHealth();
+        return result;
+    }
+};
+
+// Повторяет запись repeats раз и сообщает скорость в ходах в секунду.
+// Возвращает false, если итог повтора не совпал с записанным.
+inline bool runCombatReplay(const std::string& replayFile, uint64_t repeats) {
+    CombatReplay replay = CombatReplay::load(replayFile);
+    CombatReplayer replayer;
+    
+    ReplayResult first = replayer.run(replay);
+    uint64_t turns = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < repeats; ++i) {
+        turns += replayer.run(replay).turns;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    
+    static const char* const outcomeNames[] = {"победа", "поражение", "бой не закончен"};
+    std::cout << "Запись: " << replay.turns << " ходов, зерно " << replay.seed
+              << ", итог: " << outcomeNames[static_cast<size_t>(replay.outcome)] << "\n";
+    std::cout << "Повтор: " << first.turns << " ходов, итог: " << outcomeNames[static_cast<size_t>(first.outcome)]
+              << ", здоровье " << first.playerHealth << "/" << first.enemyHealth << "\n";
+    std::cout << "Скорость: " << (seconds > 0 ? turns / seconds : 0) << " ходов/с (" << repeats << " повторов)\n";
+    if (!first.matches(replay)) {
+        std::cout << "Итог повтора не совпадает с записью!\n";
+        return false;
+    }
+    return true;
+}
+
+class AdventureGame {
+private:
+    GameCharacter mainCharacter;
+    EventLogger<std::string> gameLogger;
+    BinaryEventLog combatLog;
+    AutosaveWorker autosave;
+    CombatReplay lastCombat;
+    std::random_device seedSource;
+    
+    void reportSaveFailures() {
+        for (const auto& failure : autosave.takeFailures()) {
+            gameLogger.recordEvent("Ошибка сохранения: " + failure);
+            std::cerr << "Ошибка сохранения: " << failure << std::endl;
+        }
+    }
+    
+public:
+    AdventureGame(const std::string& playerName) 
+        : mainCharacter(playerName, STARTING_HEALTH, STARTING_ATTACK, STARTING_DEFENSE), gameLogger("журнал_игры.txt", LoggingMode::Asynchronous),
+          combatLog("журнал_битв.bin") {
+        gameLogger.recordEvent("Начало игры. Персонаж: " + playerName);
+    }
+    
+    ~AdventureGame() {
+        autosave.flush();
+        reportSaveFailures();
+        std::ostringstream statistics;
+        autosave.report(statistics);
+        gameLogger.recordEvent(statistics.str());
+    }
+    
+    // Запись боя сохраняется в файл в конце боя; ошибка записи не прерывает игру.
+    void saveCombatReplay(CombatOutcome outcome, const GameCreature& enemy) {
+        lastCombat.finish(outcome, mainCharacter, enemy);
+        try {
+            lastCombat.save("последний_бой.replay");
+        } catch (const GameWorldException& error) {
+            gameLogger.recordEvent("Ошибка записи боя: " + std::string(error.what()));
+        }
+    }
+    
+    void initiateCombat(GameCreature& enemy) {
+        uint32_t playerId = combatLog.intern(mainCharacter.getName());
+        uint32_t enemyId = combatLog.intern(enemy.getName());
+        combatLog.record(GameEventId::CombatStarted, playerId, enemyId);
+        lastCombat.begin((static_cast<uint64_t>(seedSource()) << 32) | seedSource(), mainCharacter, enemy);
+        
+        std::cout << "\n=== НАЧАЛО БИТВЫ ===\n";
+        mainCharacter.displayCharacterInfo();
+        enemy.displayCreatureInfo();
+        std::cout << "====================\n";
+        
+        try {
+            while (mainCharacter.getHealth() > 0 && enemy.isAlive()) {
+
+                std::cout << "\nВаш ход:\n";
+                std::cout << "1. Атаковать\n";
+                std::cout << "2. Использовать предмет\n";
+                std::cout << "Выберите действие: ";
+                
+                int playerChoice;
+                std::cin >> playerChoice;
+                
+                if (playerChoice == 1) {
+                    mainCharacter.attackTarget(enemy);
+                    lastCombat.recordAttack();
+                    combatLog.record(GameEventId::PlayerAttacked, playerId, enemyId, enemy.getHealth());
+                } else if (playerChoice == 2) {
+                    mainCharacter.showCharacterInventory();
+                    std::cout << "Введите название предмета: ";
+                    std::string selectedItem;
+                    std::cin.ignore();
+                    std::getline(std::cin, selectedItem);
+                    
+                    try {
+                        lastCombat.recordItem(mainCharacter.useInventoryItem(selectedItem));
+                        combatLog.record(GameEventId::ItemUsed, playerId, combatLog.intern(selectedItem));
+                    } catch (const GameWorldException& error) {
+                        std::cerr << "Ошибка: " << error.what() << std::endl;
+                        continue;
+                    }
+                } else {
+                    std::cout << "Неверный выбор!" << std::endl;
+                    continue;
+                }
+                
+                if (!enemy.isAlive()) {
+                    int experienceReward = enemy.getAttack() * EXPERIENCE_PER_ATTACK;
+                    mainCharacter.gainExperience(experienceReward);
+                    std::cout << enemy.getName() << " побежден! Получено " << experienceReward << " опыта.\n";
+                    combatLog.record(GameEventId::CreatureDefeated, playerId, enemyId, experienceReward);
+                    autosave.request(mainCharacter, "автосохранение.sav");
+                    saveCombatReplay(CombatOutcome::PlayerWon, enemy);
+                    return;
+                }
+                
+                std::cout << "\nХод " << enemy.getName() << ":\n";
+                enemy.performAttack(mainCharacter);
+                combatLog.record(GameEventId::CreatureAttacked, enemyId, playerId, mainCharacter.getHealth());
+                
+                std::cout << "\nТекущее состояние:\n";
+                mainCharacter.displayCharacterInfo();
+                enemy.displayCreatureInfo();
+                std::cout << "====================\n";
+                
+                autosave.request(mainCharacter, "автосохранение.sav");
+                reportSaveFailures();
+            }
+        } catch (const GameWorldException& error) {
+            combatLog.record(GameEventId::CombatEnded, combatLog.intern(error.what()));
+            combatLog.flush();
+            saveCombatReplay(CombatOutcome::PlayerDefeated, enemy);
+            throw;
+        }
+        saveCombatReplay(mainCharacter.getHealth() > 0 ? CombatOutcome::Stalemate : CombatOutcome::PlayerDefeated, enemy);
+    }
+    
+    // Файл пишется в фоне; ошибка записи будет показана при следующем сохранении или загрузке.
+    void saveGameState() {
+        reportSaveFailures();
+        autosave.request(mainCharacter, "сохранение.sav");
+        gameLogger.recordEvent("Игра сохранена");
+        std::cout << "Игра сохраняется...\n";
+    }
+    
+    void loadGameState() {
+        autosave.flush();
+        reportSaveFailures();
+        try {
+            mainCharacter.loadCharacterBinary("сохранение.sav");
+            gameLogger.recordEvent("Игра загружена");
+            std::cout << "Игра загружена!\n";
+        } catch (const GameWorldException& error) {
+            gameLogger.recordEvent("Ошибка загрузки: " + std::string(error.what()));
+            std::cerr << "Ошибка загрузки: " << error.what() << std::endl;
+        }
+    }
+    
+    void addItemToCharacter(std::unique_ptr<GameItem> newItem) {
+        mainCharacter.addItemToInventory(std::move(newItem));
+    }
+    
+    void showCharacterStatus() const {
+        mainCharacter.displayCharacterInfo();
     }
     
     void showCharacterItems() const {
@@ -556,13 +2820,1561 @@ public:
     }
 };
 
-int main() {
+// Симулятор боев без ввода с клавиатуры: те же правила, что в initiateCombat,
+// но ход игрока выбирает стратегия, а поражение возвращается кодом исхода.
+enum class CombatAction : uint8_t {
+    Attack,
+    UseHealing,
+    EquipGear
+};
+
+struct SimulatedCreature {
+    std::string name;
+    int health;
+    int attack;
+    int defense;
+};
+
+inline SimulatedCreature simulatedCreature(const CreatureDefinition& definition) {
+    return {std::string(definition.name), definition.health, definition.attack, definition.defense};
+}
+
+struct BattleState {
+    int playerHealth;
+    int playerMaxHealth;
+    int playerAttack;  // без бонуса снаряжения
+    int playerDefense;
+    int potions;
+    int potionHeal;
+    int gearBonus;
+    bool gearEquipped;
+    int creatureHealth;
+    int creatureAttack;
+    int creatureDefense;
+    int turn;
+};
+
+// Счетчиковый генератор на основе SplitMix64: значение зависит только от
+// (seed, номер боя, ход, номер броска в ходе). Бои воспроизводимы по
+// отдельности и не делят состояние между потоками.
+class CombatRandom {
+private:
+    uint64_t battleKey;
+    uint64_t counter = 0;
+    
+public:
+    static constexpr uint64_t mix(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    
+    static constexpr uint64_t keyFor(uint64_t seed, uint64_t battleId) {
+        return mix(seed ^ mix(battleId));
+    }
+    
+    static constexpr uint64_t at(uint64_t key, uint32_t turn, uint32_t draw) {
+        return mix(key ^ ((static_cast<uint64_t>(turn) << 32) | draw));
+    }
+    
+    // Значения для ходов firstTurn..firstTurn+count-1 (первый бросок хода).
+    // Итерации не зависят друг от друга, и компилятор может их векторизовать.
+    static void fill(uint64_t key, uint32_t firstTurn, uint64_t* output, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            output[i] = at(key, firstTurn + static_cast<uint32_t>(i), 0);
+        }
+    }
+    
+    // Равномерное число в [0, bound) без смещения от деления по модулю.
+    static uint32_t below(uint64_t bits, uint32_t bound) {
+        return static_cast<uint32_t>(((bits >> 32) * bound) >> 32);
+    }
+    
+    CombatRandom(uint64_t seed, uint64_t battleId) : battleKey(keyFor(seed, battleId)) {}
+    
+    void beginTurn(uint32_t turn) { counter = static_cast<uint64_t>(turn) << 32; }
+    uint64_t next() { return mix(battleKey ^ counter++); }
+    uint32_t nextBelow(uint32_t bound) { return below(next(), bound); }
+};
+
+
+struct CombatPolicy {
+    const char* name;
+    CombatAction (*choose)(const BattleState& state, CombatRandom& rng);
+};
+
+inline CombatAction alwaysAttack(const BattleState&, CombatRandom&) {
+    return CombatAction::Attack;
+}
+
+// Экипируется в первый ход и пьет зелье, если следующие два удара смертельны.
+inline CombatAction cautiousPlayer(const BattleState& state, CombatRandom&) {
+    if (!state.gearEquipped && state.gearBonus > 0) return CombatAction::EquipGear;
+    int incoming = state.creatureAttack - state.playerDefense;
+    if (state.potions > 0 && incoming > 0 && state.playerHealth <= incoming * 2) {
+        return CombatAction::UseHealing;
+    }
+    return CombatAction::Attack;
+}
+
+inline CombatAction randomPlayer(const BattleState& state, CombatRandom& rng) {
+    CombatAction available[3];
+    uint32_t count = 0;
+    available[count++] = CombatAction::Attack;
+    if (state.potions > 0) available[count++] = CombatAction::UseHealing;
+    if (!state.gearEquipped) available[count++] = CombatAction::EquipGear;
+    return available[rng.nextBelow(count)];
+}
+
+constexpr CombatPolicy combatPolicies[] = {
+    {"атака", alwaysAttack},
+    {"осторожный", cautiousPlayer},
+    {"случайный", randomPlayer},
+};
+
+inline const CombatPolicy* findCombatPolicy(std::string_view name) {
+    for (const auto& policy : combatPolicies) {
+        if (name == policy.name) return &policy;
+    }
+    return nullptr;
+}
+
+struct BattleResult {
+    CombatOutcome outcome;
+    int turns;
+    int experience;
+};
+
+constexpr int MAX_SIMULATED_TURNS = 1000;
+
+// Повторяет initiateCombat: ход игрока, проверка победы, ответный удар.
+// Зелье без запаса превращается в атаку, чтобы ход не повторялся бесконечно;
+// если обе стороны не пробивают защиту, бой заканчивается ничьей.
+inline BattleResult simulateBattle(BattleState state, const CombatPolicy& policy, CombatRandom& rng) {
+    while (state.playerHealth > 0 && state.creatureHealth > 0) {
+        if (state.turn == MAX_SIMULATED_TURNS) {
+            return {CombatOutcome::Stalemate, state.turn, 0};
+        }
+        
+        rng.beginTurn(static_cast<uint32_t>(state.turn));
+        CombatAction action = policy.choose(state, rng);
+        if (action == CombatAction::UseHealing && state.potions == 0) {
+            action = CombatAction::Attack;
+        }
+        switch (action) {
+            case CombatAction::Attack: {
+                int damageDealt = state.playerAttack + (state.gearEquipped ? state.gearBonus : 0) - state.creatureDefense;
+                if (damageDealt > 0) {
+                    state.creatureHealth -= damageDealt;
+                    if (state.creatureHealth < 0) state.creatureHealth = 0;
+                }
+                break;
+            }
+            case CombatAction::UseHealing:
+                state.playerHealth = std::min(state.playerHealth + state.potionHeal, state.playerMaxHealth);
+                --state.potions;
+                break;
+            case CombatAction::EquipGear:
+                state.gearEquipped = !state.gearEquipped;
+                break;
+        }
+        ++state.turn;
+        
+        if (state.creatureHealth <= 0) {
+            return {CombatOutcome::PlayerWon, state.turn, state.creatureAttack * EXPERIENCE_PER_ATTACK};
+        }
+        
+        int damageTaken = state.creatureAttack - state.playerDefense;
+        if (damageTaken > 0) {
+            state.playerHealth -= damageTaken;
+        }
+    }
+    return {CombatOutcome::PlayerDefeated, state.turn, 0};
+}
+
+struct BattleStatistics {
+    uint64_t battles = 0;
+    uint64_t wins = 0;
+    uint64_t defeats = 0;
+    uint64_t stalemates = 0;
+    uint64_t turnsToKill = 0;
+    uint64_t experience = 0;
+    
+    void add(const BattleResult& result) {
+        ++battles;
+        switch (result.outcome) {
+            case CombatOutcome::PlayerWon:
+                ++wins;
+                turnsToKill += result.turns;
+                experience += result.experience;
+                break;
+            case CombatOutcome::PlayerDefeated:
+                ++defeats;
+                break;
+            case CombatOutcome::Stalemate:
+                ++stalemates;
+                break;
+        }
+    }
+    
+    void merge(const BattleStatistics& other) {
+        battles += other.battles;
+        wins += other.wins;
+        defeats += other.defeats;
+        stalemates += other.stalemates;
+        turnsToKill += other.turnsToKill;
+        experience += other.experience;
+    }
+};
+
+// Прогоняет battlesPerScenario боев для каждой пары (уровень, существо).
+// Работа раздается пулу потоков порциями; случайность каждого боя задана
+// seed и номером боя, поэтому результат не зависит от числа потоков.
+class CombatSimulator {
+private:
+    std::vector<SimulatedCreature> creatures;
+    int maxLevel;
+    uint64_t battlesPerScenario;
+    const CombatPolicy& policy;
+    uint64_t seed;
+    
+    static constexpr uint64_t CHUNK_BATTLES = 4096;
+    
+public:
+    CombatSimulator(std::vector<SimulatedCreature> creatureList, int levels, uint64_t battles,
+                    const CombatPolicy& playerPolicy, uint64_t randomSeed)
+        : creatures(std::move(creatureList)), maxLevel(levels), battlesPerScenario(battles),
+          policy(playerPolicy), seed(randomSeed) {}
+    
+    // Персонаж нужного уровня со стартовым снаряжением (меч +5, зелье на 30).
+    static BattleState initialState(int level, const SimulatedCreature& creature) {
+        BattleState state{};
+        state.playerMaxHealth = STARTING_HEALTH + (level - 1) * LEVEL_HEALTH_GAIN;
+        state.playerHealth = state.playerMaxHealth;
+        state.playerAttack = STARTING_ATTACK + (level - 1) * LEVEL_ATTACK_GAIN;
+        state.playerDefense = STARTING_DEFENSE + (level - 1) * LEVEL_DEFENSE_GAIN;
+        state.potions = 1;
+        state.potionHeal = 30;
+        state.gearBonus = 5;
+        state.creatureHealth = creature.health;
+        state.creatureAttack = creature.attack;
+        state.creatureDefense = creature.defense;
+        return state;
+    }
+    
+    size_t scenarioCount() const { return static_cast<size_t>(maxLevel) * creatures.size(); }
+    int scenarioLevel(size_t scenario) const { return static_cast<int>(scenario / creatures.size()) + 1; }
+    const SimulatedCreature& scenarioCreature(size_t scenario) const { return creatures[scenario % creatures.size()]; }
+    
+    std::vector<BattleStatistics> run(unsigned workerCount) const {
+        uint64_t chunksPerScenario = (battlesPerScenario + CHUNK_BATTLES - 1) / CHUNK_BATTLES;
+        uint64_t totalChunks = chunksPerScenario * scenarioCount();
+        std::atomic<uint64_t> nextChunk{0};
+        std::vector<BattleStatistics> merged(scenarioCount());
+        std::mutex mergeMutex;
+        
+        auto worker = [&]() {
+            std::vector<BattleStatistics> local(scenarioCount());
+            while (true) {
+                uint64_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= totalChunks) break;
+                
+                size_t scenario = static_cast<size_t>(chunk / chunksPerScenario);
+                uint64_t first = (chunk % chunksPerScenario) * CHUNK_BATTLES;
+                uint64_t count = std::min(CHUNK_BATTLES, battlesPerScenario - first);
+                
+                BattleState start = initialState(scenarioLevel(scenario), scenarioCreature(scenario));
+                for (uint64_t i = 0; i < count; ++i) {
+                    CombatRandom rng(seed, scenario * battlesPerScenario + first + i);
+                    local[scenario].add(simulateBattle(start, policy, rng));
+                }
+            }
+            
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            for (size_t i = 0; i < local.size(); ++i) merged[i].merge(local[i]);
+        };
+        
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < workerCount; ++i) pool.emplace_back(worker);
+        worker();
+        for (auto& thread : pool) thread.join();
+        return merged;
+    }
+    
+    void printReport(const std::vector<BattleStatistics>& results, std::ostream& output) const {
+        output << "Уровень  Существо                Побед %  Ходов до победы  Опыт/бой  Боев до уровня\n";
+        for (size_t scenario = 0; scenario < results.size(); ++scenario) {
+            const BattleStatistics& stats = results[scenario];
+            double winRate = stats.battles ? 100.0 * stats.wins / stats.battles : 0.0;
+            double turns = stats.wins ? static_cast<double>(stats.turnsToKill) / stats.wins : 0.0;
+            double experience = stats.battles ? static_cast<double>(stats.experience) / stats.battles : 0.0;
+            
+            char row[160];
+            std::snprintf(row, sizeof(row), "%7d  ", scenarioLevel(scenario));
+            const std::string& name = scenarioCreature(scenario).name;
+            size_t nameWidth = std::count_if(name.begin(), name.end(),
+                                             [](char c) { return (c & 0xC0) != 0x80; });
+            output << row << name << std::string(nameWidth < 20 ? 20 - nameWidth : 0, ' ');
+            std::snprintf(row, sizeof(row), "  %7.2f  %15.2f  %8.2f  ", winRate, turns, experience);
+            output << row;
+            if (experience > 0) {
+                std::snprintf(row, sizeof(row), "%14.2f\n", LEVEL_UP_EXPERIENCE / experience);
+                output << row;
+            } else {
+                output << "             -\n";
+            }
+        }
+    }
+};
+
+void runCombatSimulation(uint64_t battlesPerScenario, const CombatPolicy& policy) {
+    std::vector<SimulatedCreature> creatures;
+    for (const auto& definition : creatureTable) {
+        creatures.push_back(simulatedCreature(definition));
+    }
+    const int maxLevel = 10;
+    CombatSimulator simulator(std::move(creatures), maxLevel, battlesPerScenario, policy, 20240601);
+    
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+    auto started = std::chrono::steady_clock::now();
+    std::vector<BattleStatistics> results = simulator.run(workers);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    
+    uint64_t totalBattles = 0;
+    for (const auto& stats : results) totalBattles += stats.battles;
+    
+    std::cout << "Стратегия: " << policy.name << ", потоков: " << workers << "\n";
+    simulator.printReport(results, std::cout);
+    std::cout << "Боев: " << totalBattles << " за " << elapsed << " с ("
+              << static_cast<uint64_t>(totalBattles / elapsed * 60) << " боев/мин)\n";
+}
+
+// Мир боев в виде отдельных массивов компонентов: здоровье, атака, защита
+// и цель каждой сущности лежат подряд, а системы проходят по массивам
+// целиком вместо виртуального вызова на каждый объект.
+struct EntityId {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+    
+    bool operator==(const EntityId& other) const {
+        return index == other.index && generation == other.generation;
+    }
+};
+
+// Пул потоков для систем мира: диапазон делится на равные полосы,
+// вызывающий поток обрабатывает первую и ждет остальные.
+class TickScheduler {
+private:
+    std::vector<std::thread> workers;
+    std::mutex taskMutex;
+    std::condition_variable taskReady;
+    std::condition_variable taskDone;
+    std::function<void(size_t, size_t)> task;
+    size_t taskSize = 0;
+    uint64_t taskGeneration = 0;
+    size_t pendingWorkers = 0;
+    bool stopping = false;
+    
+    static constexpr size_t MIN_PARALLEL_RANGE = 16384;
+    
+    std::pair<size_t, size_t> stripe(size_t part) const {
+        size_t parts = workers.size() + 1;
+        return {taskSize * part / parts, taskSize * (part + 1) / parts};
+    }
+    
+    void workerLoop(size_t part) {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            std::unique_lock<std::mutex> lock(taskMutex);
+            taskReady.wait(lock, [&]() { return stopping || taskGeneration != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = taskGeneration;
+            auto [begin, end] = stripe(part);
+            lock.unlock();
+            
+            task(begin, end);
+            
+            lock.lock();
+            if (--pendingWorkers == 0) taskDone.notify_one();
+        }
+    }
+    
+public:
+    explicit TickScheduler(unsigned threadCount) {
+        for (unsigned i = 1; i < threadCount; ++i) {
+            workers.emplace_back(&TickScheduler::workerLoop, this, static_cast<size_t>(i));
+        }
+    }
+    
+    ~TickScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+    
+    TickScheduler(const TickScheduler&) = delete;
+    TickScheduler& operator=(const TickScheduler&) = delete;
+    
+    size_t threadCount() const { return workers.size() + 1; }
+    
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body) {
+        if (workers.empty() || count < MIN_PARALLEL_RANGE) {
+            body(0, count);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            task = body;
+            taskSize = count;
+            pendingWorkers = workers.size();
+            ++taskGeneration;
+        }
+        taskReady.notify_all();
+        
+        auto [begin, end] = stripe(0);
+        body(begin, end);
+        
+        std::unique_lock<std::mutex> lock(taskMutex);
+        taskDone.wait(lock, [&]() { return pendingWorkers == 0; });
+    }
+};
+
+// Имена сущностей хранятся через internCreatureName, поэтому мир не зависит
+// от времени жизни строки или существа, переданного в spawn.
+class CombatWorld {
+private:
+    std::vector<const std::string*> names;
+    std::vector<int32_t> health;
+    std::vector<int32_t> maxHealth;
+    std::vector<int32_t> attack;
+    std::vector<int32_t> defense;
+    std::vector<int32_t> regeneration;
+    std::vector<int32_t> incomingDamage;
+    std::vector<EntityId> targets;
+    std::vector<uint32_t> generations;
+    std::vector<uint8_t> alive;
+    std::vector<uint32_t> freeSlots;
+    size_t liveCount = 0;
+    uint64_t reapedCount = 0;
+    
+public:
+    EntityId spawn(std::string_view name, int hp, int atk, int def, int regen = 0) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = static_cast<uint32_t>(alive.size());
+            names.push_back(nullptr);
+            health.push_back(0);
+            maxHealth.push_back(0);
+            attack.push_back(0);
+            defense.push_back(0);
+            regeneration.push_back(0);
+            incomingDamage.push_back(0);
+            targets.push_back(EntityId());
+            generations.push_back(0);
+            alive.push_back(0);
+        }
+        
+        names[index] = &internCreatureName(name);
+        health[index] = hp;
+        maxHealth[index] = hp;
+        attack[index] = atk;
+        defense[index] = def;
+        regeneration[index] = regen;
+        incomingDamage[index] = 0;
+        targets[index] = EntityId();
+        alive[index] = 1;
+        ++liveCount;
+        return {index, generations[index]};
+    }
+    
+    EntityId spawn(const GameCreature& creature, int regen = 0) {
+        return spawn(creature.getName(), creature.getHealth(), creature.getAttack(), creature.getDefense(), regen);
+    }
+    
+    bool isAlive(EntityId entity) const {
+        return entity.index < alive.size() && alive[entity.index] &&
+               generations[entity.index] == entity.generation;
+    }
+    
+    void setTarget(EntityId attacker, EntityId target) {
+        if (!isAlive(attacker)) {
+            throw GameWorldException("Сущность не существует");
+        }
+        targets[attacker.index] = target;
+    }
+    
+    int getHealth(EntityId entity) const { return isAlive(entity) ? health[entity.index] : 0; }
+    const std::string& getName(EntityId entity) const {
+        if (!isAlive(entity)) {
+            throw GameWorldException("Сущность не существует");
+        }
+        return *names[entity.index];
+    }
+    size_t entityCount() const { return liveCount; }
+    uint64_t reaped() const { return reapedCount; }
+    
+    // Каждая живая сущность бьет свою цель по правилу attackTarget:
+    // урон равен атаке минус защита цели, если он положительный.
+    // Поколение меняется при гибели, поэтому совпадение поколения цели
+    // означает, что она жива. Атомарное сложение нужно только при нескольких потоках.
+    void resolveAttacks(TickScheduler& scheduler) {
+        bool shared = scheduler.threadCount() > 1;
+        scheduler.parallelFor(alive.size(), [this, shared](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!alive[i]) continue;
+                EntityId target = targets[i];
+                if (target.index >= generations.size() || generations[target.index] != target.generation) continue;
+                int damage = attack[i] - defense[target.index];
+                if (damage <= 0) continue;
+                if (shared) {
+                    std::atomic_ref<int32_t>(incomingDamage[target.index]).fetch_add(damage, std::memory_order_relaxed);
+                } else {
+                    incomingDamage[target.index] += damage;
+                }
+            }
+        });
+    }
+    
+    // Полученный урон вычитается, выжившие восстанавливают здоровье.
+    void applyDamageAndRegen(TickScheduler& scheduler) {
+        scheduler.parallelFor(alive.size(), [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int32_t hp = health[i] - incomingDamage[i];
+                incomingDamage[i] = 0;
+                if (hp > 0) hp = std::min(hp + regeneration[i], maxHealth[i]);
+                health[i] = std::max(hp, 0);
+            }
+        });
+    }
+    
+    // Погибшие освобождают место; новое поколение делает старые EntityId недействительными.
+    size_t reapDead() {
+        size_t reapedNow = 0;
+        for (size_t i = 0; i < alive.size(); ++i) {
+            if (alive[i] && health[i] == 0) {
+                alive[i] = 0;
+                ++generations[i];
+                freeSlots.push_back(static_cast<uint32_t>(i));
+                ++reapedNow;
+            }
+        }
+        liveCount -= reapedNow;
+        reapedCount += reapedNow;
+        return reapedNow;
+    }
+    
+    size_t tick(TickScheduler& scheduler) {
+        resolveAttacks(scheduler);
+        applyDamageAndRegen(scheduler);
+        return reapDead();
+    }
+};
+
+// Заполняет мир копиями существ с теми же целями.
+void populateWorld(CombatWorld& world, const std::vector<std::unique_ptr<GameCreature>>& creatures,
+                   const std::vector<uint32_t>& creatureTargets) {
+    std::vector<EntityId> entities;
+    entities.reserve(creatures.size());
+    for (const auto& creature : creatures) {
+        entities.push_back(world.spawn(*creature, 1));
+    }
+    for (size_t i = 0; i < entities.size(); ++i) {
+        world.setTarget(entities[i], entities[creatureTargets[i]]);
+    }
+}
+
+// Расчет атак миллиона сущностей: resolveAttacks на массивах компонентов
+// против того же прохода по объектам GameCreature, оба в одном потоке и
+// с накоплением урона без его применения. Полный такт мира (атаки,
+// восстановление, уборка погибших) на всех потоках выводится отдельно.
+void runWorldBenchmark(size_t entityCount) {
+    const int ticks = 50;
+    CombatRandom rng(7, 0);
+    std::vector<std::unique_ptr<GameCreature>> creatures;
+    std::vector<uint32_t> creatureTargets;
+    creatures.reserve(entityCount);
+    creatureTargets.reserve(entityCount);
+    for (size_t i = 0; i < entityCount; ++i) {
+        switch (i % 3) {
+            case 0: creatures.push_back(std::make_unique<ForestGoblin>()); break;
+            case 1: creatures.push_back(std::make_unique<AncientDragon>()); break;
+            default: creatures.push_back(std::make_unique<UndeadWarrior>()); break;
+        }
+        std::string stats = "x," + std::to_string(200 + rng.nextBelow(800)) + "," +
+                            std::to_string(5 + rng.nextBelow(20)) + "," +
+                            std::to_string(rng.nextBelow(10));
+        creatures.back()->loadCreatureData(stats);
+    }
+    for (size_t i = 0; i < entityCount; ++i) {
+        creatureTargets.push_back(rng.nextBelow(static_cast<uint32_t>(entityCount)));
+    }
+    
+    TickScheduler serial(1);
+    CombatWorld attackWorld;
+    populateWorld(attackWorld, creatures, creatureTargets);
+    auto started = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick) attackWorld.resolveAttacks(serial);
+    double arraySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    
+    std::vector<int32_t> objectDamage(entityCount, 0);
+    started = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick) {
+        for (size_t i = 0; i < entityCount; ++i) {
+            const GameCreature& attacker = *creatures[i];
+            const GameCreature& target = *creatures[creatureTargets[i]];
+            if (!attacker.isAlive() || !target.isAlive()) continue;
+            int damage = attacker.getAttack() - target.getDefense();
+            if (damage > 0) objectDamage[creatureTargets[i]] += damage;
+        }
+    }
+    double objectSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    
+    TickScheduler scheduler(std::max(1u, std::thread::hardware_concurrency()));
+    CombatWorld world;
+    populateWorld(world, creatures, creatureTargets);
+    started = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick) world.tick(scheduler);
+    double worldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    
+    double updates = static_cast<double>(entityCount) * ticks;
+    std::cout << "Сущностей: " << entityCount << ", тактов: " << ticks << "\n";
+    std::cout << "Атаки на массивах компонентов: " << arraySeconds / ticks * 1000 << " мс/такт ("
+              << arraySeconds / updates * 1e9 << " нс/сущность)\n";
+    std::cout << "Атаки на объектах GameCreature: " << objectSeconds / ticks * 1000 << " мс/такт ("
+              << objectSeconds / updates * 1e9 << " нс/сущность)\n";
+    std::cout << "Полный такт мира, потоков " << scheduler.threadCount() << ": "
+              << worldSeconds / ticks * 1000 << " мс/такт, погибло " << world.reaped() << "\n";
+}
+
+// Пакетный расчет урона по правилам атак: урон равен атаке минус защита,
+// если он положительный; затем крит удваивает его, яд добавляет 5, огонь 10.
+// Броски заранее сведены в маску, поэтому ядро не ветвится. Результат -
+// новое здоровье (не ниже нуля) и бит гибели на каждую пару.
+enum DamageProc : uint8_t {
+    ProcCritical = 1,
+    ProcPoison = 2,
+    ProcFire = 4
+};
+
+constexpr int POISON_BONUS = 5;
+constexpr int FIRE_BONUS = 10;
+
+struct DamageBatch {
+    const int32_t* attack;
+    const int32_t* defense;
+    const int32_t* health;
+    const uint8_t* procs;
+    int32_t* newHealth;
+    uint8_t* killedBits;
+    size_t count;
+};
+
+// Маска бросков для атакующего вида с шансом срабатывания в процентах.
+inline uint8_t rollProcMask(uint8_t proc, uint32_t chancePercent, uint64_t randomBits) {
+    return CombatRandom::below(randomBits, 100) < chancePercent ? proc : 0;
+}
+
+inline void resolveDamageScalar(const DamageBatch& batch, size_t begin = 0) {
+    for (size_t i = begin; i < batch.count; ++i) {
+        int32_t damage = batch.attack[i] - batch.defense[i];
+        uint8_t procs = batch.procs[i];
+        if (procs & ProcCritical) damage *= 2;
+        if (procs & ProcPoison) damage += POISON_BONUS;
+        if (procs & ProcFire) damage += FIRE_BONUS;
+        if (batch.attack[i] <= batch.defense[i]) damage = 0;
+        
+        int32_t health = batch.health[i];
+        int32_t remaining = std::max(health - damage, 0);
+        batch.newHealth[i] = remaining;
+        
+        uint8_t bit = static_cast<uint8_t>(1u << (i % 8));
+        if (i % 8 == 0) batch.killedBits[i / 8] = 0;
+        if (health > 0 && remaining == 0) batch.killedBits[i / 8] |= bit;
+    }
+}
+
+#ifdef DAMAGE_KERNEL_AVX2
+__attribute__((target("avx2")))
+inline void resolveDamageAvx2(const DamageBatch& batch) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i critBit = _mm256_set1_epi32(ProcCritical);
+    const __m256i poisonBit = _mm256_set1_epi32(ProcPoison);
+    const __m256i fireBit = _mm256_set1_epi32(ProcFire);
+    const __m256i poisonBonus = _mm256_set1_epi32(POISON_BONUS);
+    const __m256i fireBonus = _mm256_set1_epi32(FIRE_BONUS);
+    
+    size_t i = 0;
+    for (; i + 8 <= batch.count; i += 8) {
+        __m256i attack = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.attack + i));
+        __m256i defense = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.defense + i));
+        __m256i health = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.health + i));
+        __m256i procs = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(batch.procs + i)));
+        
+        __m256i damage = _mm256_sub_epi32(attack, defense);
+        __m256i penetrates = _mm256_cmpgt_epi32(attack, defense);
+        __m256i isCrit = _mm256_cmpeq_epi32(_mm256_and_si256(procs, critBit), critBit);
+        damage = _mm256_add_epi32(damage, _mm256_and_si256(damage, isCrit));
+        __m256i isPoison = _mm256_cmpeq_epi32(_mm256_and_si256(procs, poisonBit), poisonBit);
+        damage = _mm256_add_epi32(damage, _mm256_and_si256(poisonBonus, isPoison));
+        __m256i isFire = _mm256_cmpeq_epi32(_mm256_and_si256(procs, fireBit), fireBit);
+        damage = _mm256_add_epi32(damage, _mm256_and_si256(fireBonus, isFire));
+        damage = _mm256_and_si256(damage, penetrates);
+        
+        __m256i remaining = _mm256_max_epi32(_mm256_sub_epi32(health, damage), zero);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(batch.newHealth + i), remaining);
+        
+        __m256i killed = _mm256_and_si256(_mm256_cmpgt_epi32(health, zero), _mm256_cmpeq_epi32(remaining, zero));
+        batch.killedBits[i / 8] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(killed)));
+    }
+    resolveDamageScalar(batch, i);
+}
+#endif
+
+inline bool damageKernelUsesAvx2() {
+#ifdef DAMAGE_KERNEL_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+inline void resolveDamage(const DamageBatch& batch) {
+#ifdef DAMAGE_KERNEL_AVX2
+    if (damageKernelUsesAvx2()) {
+        resolveDamageAvx2(batch);
+        return;
+    }
+#endif
+    resolveDamageScalar(batch);
+}
+
+// Атакующие с одним видом броска, как Character, Monster и Boss в
+// "1.3 Lab.cpp": один виртуальный вызов на каждую атаку.
+class ProcAttacker {
+public:
+    virtual ~ProcAttacker() {}
+    virtual int damageAgainst(int attack, int defense, uint8_t procs) const = 0;
+};
+
+class CriticalAttacker : public ProcAttacker {
+public:
+    int damageAgainst(int attack, int defense, uint8_t procs) const override {
+        int damage = attack - defense;
+        if (damage <= 0) return 0;
+        return (procs & ProcCritical) ? damage * 2 : damage;
+    }
+};
+
+class PoisonAttacker : public ProcAttacker {
+public:
+    int damageAgainst(int attack, int defense, uint8_t procs) const override {
+        int damage = attack - defense;
+        if (damage <= 0) return 0;
+        return (procs & ProcPoison) ? damage + POISON_BONUS : damage;
+    }
+};
+
+class FireAttacker : public ProcAttacker {
+public:
+    int damageAgainst(int attack, int defense, uint8_t procs) const override {
+        int damage = attack - defense;
+        if (damage <= 0) return 0;
+        return (procs & ProcFire) ? damage + FIRE_BONUS : damage;
+    }
+};
+
+void runDamageKernelBenchmark() {
+    const size_t pairs = 1 << 20;
+    const int rounds = 50;
+    const struct { uint8_t proc; uint32_t chance; } procTable[] = {
+        {ProcCritical, 20}, {ProcPoison, 30}, {ProcFire, 40},
+    };
+    
+    std::vector<int32_t> attack(pairs), defense(pairs), health(pairs);
+    std::vector<uint8_t> procs(pairs);
+    std::vector<std::unique_ptr<ProcAttacker>> attackers;
+    CombatRandom rng(43, 0);
+    for (size_t i = 0; i < pairs; ++i) {
+        attack[i] = 5 + static_cast<int32_t>(rng.nextBelow(30));
+        defense[i] = static_cast<int32_t>(rng.nextBelow(20));
+        health[i] = static_cast<int32_t>(rng.nextBelow(60));
+        procs[i] = rollProcMask(procTable[i % 3].proc, procTable[i % 3].chance, rng.next());
+        switch (i % 3) {
+            case 0: attackers.push_back(std::make_unique<CriticalAttacker>()); break;
+            case 1: attackers.push_back(std::make_unique<PoisonAttacker>()); break;
+            default: attackers.push_back(std::make_unique<FireAttacker>()); break;
+        }
+    }
+    
+    std::vector<int32_t> scalarHealth(pairs), vectorHealth(pairs), objectHealth(pairs);
+    std::vector<uint8_t> scalarKilled((pairs + 7) / 8), vectorKilled((pairs + 7) / 8), objectKilled((pairs + 7) / 8);
+    auto batchFor = [&](std::vector<int32_t>& newHealth, std::vector<uint8_t>& killed) {
+        return DamageBatch{attack.data(), defense.data(), health.data(), procs.data(),
+                           newHealth.data(), killed.data(), pairs};
+    };
+    
+    auto measure = [&](auto resolve) {
+        auto started = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; ++round) resolve();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+        return elapsed / (static_cast<double>(pairs) * rounds);
+    };
+    
+    double objectCost = measure([&]() {
+        for (size_t i = 0; i < pairs; ++i) {
+            int damage = attackers[i]->damageAgainst(attack[i], defense[i], procs[i]);
+            objectHealth[i] = std::max(health[i] - damage, 0);
+            if (i % 8 == 0) objectKilled[i / 8] = 0;
+            if (health[i] > 0 && objectHealth[i] == 0) objectKilled[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    });
+    double scalarCost = measure([&]() { resolveDamageScalar(batchFor(scalarHealth, scalarKilled)); });
+    
+    std::cout << "Виртуальные вызовы: " << objectCost << " нс/пара\n";
+    std::cout << "Скалярное ядро: " << scalarCost << " нс/пара\n";
+    bool objectMatches = objectHealth == scalarHealth && objectKilled == scalarKilled;
+    std::cout << "Совпадает с виртуальными вызовами: " << (objectMatches ? "да" : "нет") << "\n";
+    
+#ifdef DAMAGE_KERNEL_AVX2
+    if (damageKernelUsesAvx2()) {
+        double vectorCost = measure([&]() { resolveDamageAvx2(batchFor(vectorHealth, vectorKilled)); });
+        bool identical = vectorHealth == scalarHealth && vectorKilled == scalarKilled;
+        std::cout << "AVX2: " << vectorCost << " нс/пара\n";
+        std::cout << "AVX2 совпадает со скалярным: " << (identical ? "да" : "нет") << "\n";
+        return;
+    }
+#endif
+    std::cout << "AVX2 недоступен\n";
+}
+
+// Стоимость записи журнала за один ход битвы (две атаки) на игровом потоке.
+void runLoggingBenchmark() {
+    const int turns = 200000;
+    const std::string textFile = "замер_журнала.txt";
+    const std::string binaryFile = "замер_журнала.bin";
+    std::string playerName = "Герой";
+    std::string enemyName = "Древний дракон";
+
+    auto perTurn = [turns](std::chrono::steady_clock::duration elapsed) {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / turns;
+    };
+
+    double synchronousCost, asynchronousCost, binaryCost;
+    {
+        EventLogger<std::string> logger(textFile, LoggingMode::Synchronous);
+        auto started = std::chrono::steady_clock::now();
+        for (int turn = 0; turn < turns; ++turn) {
+            logger.recordEvent(playerName + " атакует " + enemyName);
+            logger.recordEvent(enemyName + " атакует " + playerName);
+        }
+        synchronousCost = perTurn(std::chrono::steady_clock::now() - started);
+    }
+    {
+        EventLogger<std::string> logger(textFile, LoggingMode::Asynchronous);
+        auto started = std::chrono::steady_clock::now();
+        for (int turn = 0; turn < turns; ++turn) {
+            logger.recordEvent(playerName + " атакует " + enemyName);
+            logger.recordEvent(enemyName + " атакует " + playerName);
+        }
+        asynchronousCost = perTurn(std::chrono::steady_clock::now() - started);
+    }
+    {
+        BinaryEventLog logger(binaryFile);
+        auto started = std::chrono::steady_clock::now();
+        uint32_t playerId = logger.intern(playerName);
+        uint32_t enemyId = logger.intern(enemyName);
+        for (int turn = 0; turn < turns; ++turn) {
+            logger.record(GameEventId::PlayerAttacked, playerId, enemyId, turn);
+            logger.record(GameEventId::CreatureAttacked, enemyId, playerId, turn);
+        }
+        binaryCost = perTurn(std::chrono::steady_clock::now() - started);
+    }
+    std::remove(textFile.c_str());
+    std::remove(binaryFile.c_str());
+
+    std::cout << "Текст, синхронно: " << synchronousCost << " нс/ход\n";
+    std::cout << "Текст, асинхронно: " << asynchronousCost << " нс/ход\n";
+    std::cout << "Двоичный журнал: " << binaryCost << " нс/ход (в "
+              << synchronousCost / binaryCost << " раз дешевле синхронного)\n";
+}
+
+// Сравнение с прежним хранилищем: линейный поиск по копиям имён и удаление
+// из середины вектора.
+void runStorageBenchmark() {
+    class LinearItemStorage {
+    public:
+        std::vector<std::unique_ptr<GameItem>> storedItems;
+
+        GameItem* findItem(const std::string& itemName) {
+            for (auto& item : storedItems) {
+                if (std::string(item->getName()) == itemName) return item.get();
+            }
+            return nullptr;
+        }
+
+        void removeItem(const std::string& itemToRemove) {
+            for (auto it = storedItems.begin(); it != storedItems.end(); ++it) {
+                if (std::string((*it)->getName()) == itemToRemove) {
+                    storedItems.erase(it);
+                    return;
+                }
+            }
+        }
+    };
+
+    const int itemCount = 5000;
+    const int operations = 20000;
+    std::vector<std::string> names;
+    for (int i = 0; i < itemCount; ++i) names.push_back("Товар торговца №" + std::to_string(i));
+
+    std::mt19937 random(11);
+    std::vector<int> picks(operations);
+    for (auto& pick : picks) pick = static_cast<int>(random() % itemCount);
+
+    LinearItemStorage linear;
+    ItemStorage indexed;
+    for (const auto& name : names) {
+        linear.storedItems.push_back(std::make_unique<HealingItem>(name, "Зелье", 10));
+        indexed.addItem(std::make_unique<HealingItem>(name, "Зелье", 10));
+    }
+
+    auto measure = [operations](auto operation) {
+        auto started = std::chrono::steady_clock::now();
+        operation();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / operations;
+    };
+
+    size_t found = 0;
+    double linearFind = measure([&] { for (int pick : picks) found += linear.findItem(names[pick]) != nullptr; });
+    double indexedFind = measure([&] { for (int pick : picks) found += indexed.findItem(names[pick]) != nullptr; });
+    double linearReplace = measure([&] {
+        for (int pick : picks) {
+            linear.removeItem(names[pick]);
+            linear.storedItems.push_back(std::make_unique<HealingItem>(names[pick], "Зелье", 10));
+        }
+    });
+    double indexedReplace = measure([&] {
+        for (int pick : picks) {
+            indexed.removeItem(names[pick]);
+            indexed.addItem(std::make_unique<HealingItem>(names[pick], "Зелье", 10));
+        }
+    });
+
+    std::cout << "Предметов: " << itemCount << ", найдено " << found << "\n";
+    std::cout << "Поиск: " << linearFind << " нс -> " << indexedFind << " нс\n";
+    std::cout << "Удаление и добавление: " << linearReplace << " нс -> " << indexedReplace << " нс\n";
+}
+
+// Цена выбора обработчика при использовании предмета: прежняя цепочка
+// dynamic_cast против switch по виду. Эффект применяется к статам бойца.
+void runItemDispatchBenchmark() {
+    const int uses = 5000000;
+    std::vector<std::unique_ptr<GameItem>> items;
+    for (int i = 0; i < 64; ++i) {
+        if (i % 3 == 0) items.push_back(std::make_unique<CombatGear>("Меч", "", 1 + i % 5));
+        else items.push_back(std::make_unique<HealingItem>("Зелье", "", 5 + i % 7));
+    }
+
+    std::atomic<int> observedStats{0};
+    auto measure = [uses, &observedStats](auto useItem) {
+        int health = 100, attack = 10;
+        auto started = std::chrono::steady_clock::now();
+        for (int i = 0; i < uses; ++i) useItem(i, health, attack);
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+        observedStats.store(health + attack, std::memory_order_relaxed);
+        return elapsed / uses;
+    };
+
+    double castCost = measure([&items](int i, int& health, int& attack) {
+        GameItem* item = items[(i * 7) % items.size()].get();
+        if (auto healingItem = dynamic_cast<HealingItem*>(item)) {
+            health = (health + healingItem->getHealAmount()) % 1000;
+        } else if (auto weaponItem = dynamic_cast<CombatGear*>(item)) {
+            attack = (attack + weaponItem->getDamageBonus()) % 1000;
+        }
+    });
+    double switchCost = measure([&items](int i, int& health, int& attack) {
+        GameItem* item = items[(i * 7) % items.size()].get();
+        switch (item->getKind()) {
+            case ItemKind::HealingItem:
+                health = (health + static_cast<HealingItem*>(item)->getHealAmount()) % 1000;
+                break;
+            case ItemKind::CombatGear:
+                attack = (attack + static_cast<CombatGear*>(item)->getDamageBonus()) % 1000;
+                break;
+            default:
+                break;
+        }
+    });
+
+    std::cout << "dynamic_cast: " << castCost << " нс/предмет\n";
+    std::cout << "switch по виду: " << switchCost << " нс/предмет\n";
+}
+
+void runParseBenchmark() {
+    const int records = 500000;
+    const std::string benchFile = "инвентарь_тест.csv";
+    {
+        std::ofstream outputFile(benchFile);
+        for (int i = 0; i < records; ++i) {
+            if (i % 2 == 0) {
+                outputFile << CombatGear("Меч " + std::to_string(i), "Острый, стальной", i % 9).saveData() << "\n";
+            } else {
+                outputFile << HealingItem("Зелье " + std::to_string(i), "Лечит \"быстро\"", i % 50).saveData() << "\n";
+            }
+        }
+    }
+
+    ItemStorage storage;
+    auto started = std::chrono::steady_clock::now();
+    storage.loadInventory(benchFile);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::remove(benchFile.c_str());
+
+    std::cout << "Загружено записей: " << storage.itemCount() << " из " << records << "\n";
+    std::cout << "Скорость разбора: " << static_cast<long long>(records / elapsed) << " записей/с\n";
+}
+
+// Сравнение mt19937_64 с счетчиковым генератором: по одному значению и пакетом.
+void runRandomBenchmark() {
+    const size_t values = 1 << 24;
+    std::vector<uint64_t> batch(1024);
+    std::atomic<uint64_t> observed{0};
+    
+    auto measure = [&observed](auto generate) {
+        auto started = std::chrono::steady_clock::now();
+        uint64_t checksum = generate();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+        observed.fetch_xor(checksum, std::memory_order_relaxed);
+        return elapsed / values;
+    };
+    
+    double engineCost = measure([]() {
+        std::mt19937_64 engine(42);
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < values; ++i) checksum ^= engine();
+        return checksum;
+    });
+    double scalarCost = measure([]() {
+        CombatRandom rng(42, 0);
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < values; ++i) {
+            rng.beginTurn(static_cast<uint32_t>(i));
+            checksum ^= rng.next();
+        }
+        return checksum;
+    });
+    double batchCost = measure([&batch]() {
+        uint64_t key = CombatRandom::keyFor(42, 0);
+        uint64_t checksum = 0;
+        for (size_t turn = 0; turn < values; turn += batch.size()) {
+            CombatRandom::fill(key, static_cast<uint32_t>(turn), batch.data(), batch.size());
+            for (uint64_t value : batch) checksum ^= value;
+        }
+        return checksum;
+    });
+    
+    std::cout << "mt19937_64: " << engineCost << " нс/число\n";
+    std::cout << "CombatRandom::next: " << scalarCost << " нс/число\n";
+    std::cout << "CombatRandom::fill: " << batchCost << " нс/число\n";
+}
+
+// Волны по 1000 существ: make_unique против пула с прототипами.
+void runSpawnBenchmark() {
+    const int waves = 2000;
+    const int waveSize = 1000;
+    const CreatureSpecies speciesCycle[] = {
+        CreatureSpecies::ForestGoblin, CreatureSpecies::UndeadWarrior,
+        CreatureSpecies::ForestGoblin, CreatureSpecies::AncientDragon,
+    };
+    std::atomic<int> observedHealth{0};
+    
+    auto measure = [&](const char* label, auto spawnWave) {
+        spawnWave();
+        uint64_t allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+        auto started = std::chrono::steady_clock::now();
+        for (int wave = 0; wave < waves; ++wave) spawnWave();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        uint64_t allocations = heapAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+        
+        double spawns = static_cast<double>(waves) * waveSize;
+        std::cout << label << ": " << static_cast<uint64_t>(spawns / elapsed) << " существ/с, "
+                  << allocations / spawns << " выделений на существо\n";
+    };
+    
+    std::vector<std::unique_ptr<GameCreature>> heapWave;
+    heapWave.reserve(waveSize);
+    measure("make_unique", [&]() {
+        for (int i = 0; i < waveSize; ++i) {
+            switch (speciesCycle[i % 4]) {
+                case CreatureSpecies::ForestGoblin: heapWave.push_back(std::make_unique<ForestGoblin>()); break;
+                case CreatureSpecies::AncientDragon: heapWave.push_back(std::make_unique<AncientDragon>()); break;
+                default: heapWave.push_back(std::make_unique<UndeadWarrior>()); break;
+            }
+        }
+        observedHealth.fetch_add(heapWave.back()->getHealth(), std::memory_order_relaxed);
+        heapWave.clear();
+    });
+    
+    CreatureFactory factory;
+    std::vector<PooledCreature> pooledWave;
+    pooledWave.reserve(waveSize);
+    measure("пул", [&]() {
+        for (int i = 0; i < waveSize; ++i) {
+            pooledWave.push_back(factory.spawn(speciesCycle[i % 4]));
+        }
+        observedHealth.fetch_add(pooledWave.back()->getHealth(), std::memory_order_relaxed);
+        pooledWave.clear();
+    });
+    
+    std::cout << "Создано из пула: гоблинов " << factory.spawnCount(CreatureSpecies::ForestGoblin)
+              << ", драконов " << factory.spawnCount(CreatureSpecies::AncientDragon)
+              << ", нежити " << factory.spawnCount(CreatureSpecies::UndeadWarrior) << "\n";
+    reportHeapCounting(std::cout);
+}
+
+// Пауза игрового цикла: синхронное сохранение против снимка для фоновой записи.
+void runAutosaveBenchmark() {
+    const int items = 10000;
+    const int saves = 200;
+    const std::string benchFile = "автосохранение_тест.sav";
+    
+    GameCharacter character("Тест", STARTING_HEALTH, STARTING_ATTACK, STARTING_DEFENSE);
+    for (int i = 0; i < items; ++i) {
+        character.addItemToInventory(std::make_unique<HealingItem>("Зелье " + std::to_string(i), "Лечит", 10));
+    }
+    
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) character.saveCharacterBinary(benchFile);
+    double syncMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count() / 10;
+    
+    double copyMicros = 0;
+    {
+        AutosaveWorker autosave;
+        for (int i = 0; i < saves; ++i) {
+            autosave.request(character, benchFile);
+            auto mutated = std::chrono::steady_clock::now();
+            character.addItemToInventory(std::make_unique<CombatGear>("Меч", "", 1));
+            copyMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - mutated).count();
+        }
+        autosave.flush();
+        std::cout << "Синхронное сохранение: " << syncMicros << " мкс\n";
+        autosave.report(std::cout);
+        std::cout << "Первое изменение инвентаря после снимка: " << copyMicros / saves << " мкс\n";
+    }
+    std::remove(benchFile.c_str());
+}
+
+// Атаки через виртуальный вызов по указателю на GameCreature против прямых
+// вызовов по конкретному виду из таблицы, где урон встраивается.
+void runCreatureBenchmark() {
+    const size_t perSpecies = 300000;
+    const int rounds = 20;
+    const int defenses[] = {3, 5, 7, 11};
+    std::atomic<long long> observedDamage{0};
+    
+    std::vector<std::unique_ptr<GameCreature>> mixed;
+    mixed.reserve(perSpecies * 3);
+    uint64_t allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < perSpecies; ++i) {
+        mixed.push_back(std::make_unique<ForestGoblin>());
+        mixed.push_back(std::make_unique<AncientDragon>());
+        mixed.push_back(std::make_unique<UndeadWarrior>());
+    }
+    double heapAllocationsPerCreature =
+        static_cast<double>(heapAllocations.load(std::memory_order_relaxed) - allocationsBefore) / mixed.size();
+    
+    std::vector<ForestGoblin> goblins(perSpecies);
+    std::vector<AncientDragon> dragons(perSpecies);
+    std::vector<UndeadWarrior> undead(perSpecies);
+    allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < perSpecies; ++i) {
+        goblins[i] = ForestGoblin();
+        dragons[i] = AncientDragon();
+        undead[i] = UndeadWarrior();
+    }
+    uint64_t valueAllocations = heapAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+    
+    auto measure = [&](auto attackAll) {
+        auto started = std::chrono::steady_clock::now();
+        long long damage = 0;
+        for (int round = 0; round < rounds; ++round) damage += attackAll(defenses[round % 4]);
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+        observedDamage.fetch_add(damage, std::memory_order_relaxed);
+        return elapsed / (static_cast<double>(perSpecies) * 3 * rounds);
+    };
+    
+    double virtualCost = measure([&](int defense) {
+        long long damage = 0;
+        for (const auto& creature : mixed) damage += creature->damageAgainst(defense);
+        return damage;
+    });
+    double directCost = measure([&](int defense) {
+        long long damage = 0;
+        for (const auto& creature : goblins) damage += creature.damageAgainst(defense);
+        for (const auto& creature : dragons) damage += creature.damageAgainst(defense);
+        for (const auto& creature : undead) damage += creature.damageAgainst(defense);
+        return damage;
+    });
+    
+    std::cout << "Виртуальный вызов: " << virtualCost << " нс/атака, "
+              << heapAllocationsPerCreature << " выделений на существо\n";
+    std::cout << "Вид из таблицы: " << directCost << " нс/атака, "
+              << valueAllocations << " выделений на " << perSpecies * 3 << " существ\n";
+    reportHeapCounting(std::cout);
+}
+
+// Загрузка инвентаря до и после открытия каталога: предмет из каталога
+// хранит только номер записи и выделяется одним блоком без строк. Остальные
+// выделения на предмет приходятся на стопку и индекс имен инвентаря.
+void runCatalogBenchmark() {
+    const int items = 20000;
+    const int loads = 20;
+    const std::string sourceFile = "каталог_тест.csv";
+    const std::string catalogFile = "каталог_тест.bin";
+    const std::string saveFile = "каталог_тест.sav";
+    
+    {
+        std::ofstream source(sourceFile);
+        for (int i = 0; i < items; ++i) {
+            source << (i % 2 ? "Зелье" : "Оружие") << ",Предмет с длинным названием " << i
+                   << ",Описание предмета из общего каталога игры номер " << i << "," << i % 50 << "\n";
+        }
+    }
+    ItemCatalog::build(sourceFile, catalogFile);
+    
+    GameCharacter character("Тест", STARTING_HEALTH, STARTING_ATTACK, STARTING_DEFENSE);
+    for (int i = 0; i < items; ++i) {
+        std::string name = "Предмет с длинным названием " + std::to_string(i);
+        std::string description = "Описание предмета из общего каталога игры номер " + std::to_string(i);
+        character.addItemToInventory(makeItem(i % 2 ? ItemKind::HealingItem : ItemKind::CombatGear, name, description, i % 50));
+    }
+    character.saveCharacterBinary(saveFile);
+    
+    auto measure = [&](const char* label) {
+        uint64_t allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+        auto started = std::chrono::steady_clock::now();
+        for (int i = 0; i < loads; ++i) character.loadCharacterBinary(saveFile);
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+        double allocations = static_cast<double>(heapAllocations.load(std::memory_order_relaxed) - allocationsBefore);
+        std::cout << label << ": " << elapsed / (static_cast<double>(items) * loads) << " нс/предмет, "
+                  << allocations / (static_cast<double>(items) * loads) << " выделений на предмет\n";
+    };
+    
+    measure("Собственные строки");
+    itemCatalog().open(catalogFile);
+    measure("Каталог предметов");
+    std::cout << "Записей в каталоге: " << itemCatalog().size() << "\n";
+    reportHeapCounting(std::cout);
+    
+    std::remove(sourceFile.c_str());
+    std::remove(catalogFile.c_str());
+    std::remove(saveFile.c_str());
+}
+
+// 10000 одинаковых зелий: одна стопка в инвентаре, и каждое использование
+// только уменьшает счетчик.
+void runStackBenchmark() {
+    const uint32_t potions = 10000;
+    GameCharacter character("Тест", STARTING_HEALTH, STARTING_ATTACK, STARTING_DEFENSE);
+    
+    auto started = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < potions; ++i) {
+        character.addItemToInventory(std::make_unique<HealingItem>("Целебное зелье", "Восстанавливает здоровье", 30));
+    }
+    double addCost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / potions;
+    size_t stacks = character.snapshot().items->size();
+    
+    double useCost;
+    {
+        SilencedOutput quiet(std::cout);
+        started = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < potions; ++i) character.useInventoryItem("Целебное зелье");
+        useCost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / potions;
+    }
+    
+    std::cout << "Зелий: " << potions << ", ячеек в инвентаре: " << stacks << "\n";
+    std::cout << "Добавление: " << addCost << " нс, использование: " << useCost << " нс\n";
+    std::cout << "Ячеек после использования всех зелий: " << character.snapshot().items->size() << "\n";
+}
+
+// Чтение итоговых характеристик из кэша против пересчета с десятью
+// активными эффектами при каждом чтении.
+void runStatCacheBenchmark() {
+    const int reads = 10000000;
+    GameCharacter character("Тест", STARTING_HEALTH, STARTING_ATTACK, STARTING_DEFENSE);
+    character.addItemToInventory(std::make_unique<CombatGear>("Стальной меч", "Острый стальной меч", 5));
+    {
+        SilencedOutput quiet(std::cout);
+        character.useInventoryItem("Стальной меч");
+    }
+    for (int i = 0; i < 10; ++i) {
+        character.addBuff(StatModifier{static_cast<CharacterStat>(i % 3), 1});
+    }
+    
+    std::atomic<long long> observed{0};
+    auto started = std::chrono::steady_clock::now();
+    long long total = 0;
+    for (int i = 0; i < reads; ++i) total += character.getAttack() + character.getDefense();
+    double cachedCost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / reads;
+    observed.fetch_add(total, std::memory_order_relaxed);
+    
+    started = std::chrono::steady_clock::now();
+    total = 0;
+    for (int i = 0; i < reads; ++i) {
+        character.addBuff(StatModifier{CharacterStat::MaxHealth, 0});
+        character.addBuff(StatModifier{CharacterStat::Attack, 0});
+        total += character.getAttack() + character.getDefense();
+        if (i % 64 == 63) character.clearBuffs();
+    }
+    double invalidatedCost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / reads;
+    observed.fetch_add(total, std::memory_order_relaxed);
+    
+    std::cout << "Атака и защита из кэша: " << cachedCost << " нс\n";
+    std::cout << "После изменения эффектов атаки и здоровья: " << invalidatedCost << " нс\n";
+}
+
+// Торговля между персонажами из тысяч потоков. Каждый торговец носит
+// снаряжение из своей первой стопки, а владелец торговца 0 все время
+// снимает и надевает его, пока с ним торгуют, и снимает снимки остальных. После обменов проверяется,
+// что каждого предмета столько же, сколько было, что счетчики хранилищ
+// сходятся со стопками и что надетое снаряжение не ушло вместе со стопкой.
+// Возвращает false, если инвариант нарушен.
+bool runTradeBenchmark(size_t threadCount) {
+    const size_t characterCount = 256;
+    const uint32_t tradesPerThread = 200;
+    const uint32_t kinds = 12;
+    const uint32_t stackSize = 50;
+    
+    std::vector<std::string> names;
+    for (uint32_t kind = 0; kind < kinds; ++kind) names.push_back("Товар " + std::to_string(kind));
+    
+    std::vector<GameCharacter> traders;
+    traders.reserve(characterCount);
+    for (size_t i = 0; i < characterCount; ++i) {
+        traders.emplace_back("Торговец " + std::to_string(i), STARTING_HEALTH, STARTING_ATTACK, STARTING_DEFENSE);
+        for (uint32_t kind = 0; kind < kinds; ++kind) {
+            for (uint32_t copy = 0; copy < stackSize; ++copy) {
+                if (kind % 3 == 0) {
+                    traders[i].addItemToInventory(std::make_unique<CombatGear>(names[kind], "Товар на обмен", 1 + kind));
+                } else {
+                    traders[i].addItemToInventory(std::make_unique<HealingItem>(names[kind], "Товар на обмен", 5 + kind));
+                }
+            }
+        }
+    }
+    
+    std::optional<SilencedOutput> quiet(std::in_place, std::cout);
+    for (auto& trader : traders) trader.useInventoryItem(names[0]);
+    
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> refused{0};
+    std::atomic<bool> ownerConsistent{true};
+    std::latch startTrading(static_cast<std::ptrdiff_t>(threadCount) + 2);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount + 1);
+    threads.emplace_back([&] {
+        startTrading.arrive_and_wait();
+        for (uint32_t turn = 0; turn < tradesPerThread * 10; ++turn) {
+            try {
+                traders[0].useInventoryItem(names[0]);
+            } catch (const GameWorldException&) {
+            }
+            if (traders[0].getAttack() < STARTING_ATTACK) ownerConsistent = false;
+            // Снимок для автосохранения: позиция снаряжения должна указывать
+            // на надетую стопку в том же списке, хотя со стопками торгуют.
+            CharacterSnapshot state = traders[1 + turn % (characterCount - 1)].snapshot();
+            if (state.equippedPosition >= state.items->size() ||
+                (*state.items)[state.equippedPosition].item->getName() != names[0]) {
+                ownerConsistent = false;
+            }
+        }
+    });
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            CombatRandom rng(17, t);
+            uint64_t done = 0, failed = 0;
+            startTrading.arrive_and_wait();
+            for (uint32_t trade = 0; trade < tradesPerThread; ++trade) {
+                rng.beginTurn(trade);
+                size_t giver = rng.nextBelow(characterCount);
+                size_t receiver = (giver + 1 + rng.nextBelow(characterCount - 1)) % characterCount;
+                const std::string& name = names[rng.nextBelow(kinds)];
+                try {
+                    traders[giver].giveItem(traders[receiver], name, 1 + rng.nextBelow(5));
+                    ++done;
+                } catch (const GameWorldException&) {
+                    ++failed;
+                }
+            }
+            completed.fetch_add(done, std::memory_order_relaxed);
+            refused.fetch_add(failed, std::memory_order_relaxed);
+        });
+    }
+    auto started = std::chrono::steady_clock::now();
+    startTrading.arrive_and_wait();
+    for (auto& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    quiet.reset();
+    
+    std::unordered_map<std::string_view, uint64_t> totals;
+    bool consistent = ownerConsistent.load();
+    for (size_t i = 0; i < characterCount; ++i) {
+        const GameCharacter& trader = traders[i];
+        std::shared_ptr<const GameItem> gear = trader.getEquippedGear();
+        if (i != 0 && (!gear || gear->getName() != names[0])) consistent = false;
+        int bonus = gear ? static_cast<const CombatGear&>(*gear).getDamageBonus() : 0;
+        if (trader.getAttack() != STARTING_ATTACK + bonus) consistent = false;
+        
+        CharacterSnapshot state = trader.snapshot();
+        uint64_t stacked = 0;
+        for (const auto& stack : *state.items) {
+            if (stack.count == 0) consistent = false;
+            totals[stack.item->getName()] += stack.count;
+            stacked += stack.count;
+        }
+        if (state.items->size() > kinds) consistent = false;
+        if (stacked != trader.inventoryItemCount()) consistent = false;
+    }
+    for (const auto& name : names) {
+        if (totals[name] != static_cast<uint64_t>(characterCount) * stackSize) consistent = false;
+    }
+    
+    std::cout << "Потоков: " << threadCount << ", персонажей: " << characterCount << "\n";
+    std::cout << "Обменов: " << completed.load() << ", отклонено: " << refused.load()
+              << ", за " << seconds << " с (" << static_cast<long long>(completed.load() / seconds) << " обменов/с)\n";
+    std::cout << (consistent ? "Предметы не потеряны и не удвоены\n" : "Нарушен учет предметов!\n");
+    return consistent;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 && std::string(argv[1]) == "--decode") {
+        try {
+            decodeEventLog(argv[2], std::cout);
+        } catch (const std::exception& error) {
+            std::cerr << "Ошибка: " << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-log") {
+        runLoggingBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-storage") {
+        runStorageBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-items") {
+        runItemDispatchBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-rng") {
+        runRandomBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-spawn") {
+        runSpawnBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-world") {
+        runWorldBenchmark(argc > 2 ? std::stoull(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-damage") {
+        runDamageKernelBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-autosave") {
+        runAutosaveBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-creatures") {
+        runCreatureBenchmark();
+        return 0;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--replay") {
+        try {
+            return runCombatReplay(argv[2], argc > 3 ? std::stoull(argv[3]) : 100000) ? 0 : 1;
+        } catch (const std::exception& error) {
+            std::cerr << "Ошибка: " << error.what() << std::endl;
+            return 1;
+        }
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-stacks") {
+        runStackBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-stats") {
+        runStatCacheBenchmark();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-trade") {
+        return runTradeBenchmark(argc > 2 ? std::stoull(argv[2]) : 2000) ? 0 : 1;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-catalog") {
+        try {
+            runCatalogBenchmark();
+        } catch (const std::exception& error) {
+            std::cerr << "Ошибка: " << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 3 && std::string(argv[1]) == "--build-catalog") {
+        try {
+            ItemCatalog::build(argv[2], argv[3]);
+        } catch (const std::exception& error) {
+            std::cerr << "Ошибка: " << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--simulate") {
+        uint64_t battles = argc > 2 ? std::stoull(argv[2]) : 200000;
+        const CombatPolicy* policy = findCombatPolicy(argc > 3 ? argv[3] : "осторожный");
+        if (!policy) {
+            std::cerr << "Неизвестная стратегия. Доступны:";
+            for (const auto& known : combatPolicies) std::cerr << " " << known.name;
+            std::cerr << std::endl;
+            return 1;
+        }
+        runCombatSimulation(battles, *policy);
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-parse") {
+        try {
+            runParseBenchmark();
+        } catch (const std::exception& error) {
+            std::cerr << "Ошибка: " << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (std::ifstream("каталог_предметов.bin")) {
+        try {
+            itemCatalog().open("каталог_предметов.bin");
+        } catch (const std::exception& error) {
+            std::cerr << "Каталог предметов не загружен: " << error.what() << std::endl;
+        }
+    }
+
     try {
         std::cout << "Введите имя вашего персонажа: ";
         std::string playerName;
         std::getline(std::cin, playerName);
         
         AdventureGame gameSession(playerName);
+        CreatureFactory creatureFactory;
         
         gameSession.addItemToCharacter(std::make_unique<CombatGear>("Стальной меч", "Острый стальной меч", 5));
         gameSession.addItemToCharacter(std::make_unique<HealingItem>("Целебное зелье", "Восстанавливает здоровье", 30));
@@ -585,18 +4397,18 @@ int main() {
             try {
                 switch (menuChoice) {
                     case 1: {
-                        ForestGoblin goblinEnemy;
-                        gameSession.initiateCombat(goblinEnemy);
+                        PooledCreature goblinEnemy = creatureFactory.spawn(CreatureSpecies::ForestGoblin);
+                        gameSession.initiateCombat(*goblinEnemy);
                         break;
                     }
                     case 2: {
-                        AncientDragon dragonEnemy;
-                        gameSession.initiateCombat(dragonEnemy);
+                        PooledCreature dragonEnemy = creatureFactory.spawn(CreatureSpecies::AncientDragon);
+                        gameSession.initiateCombat(*dragonEnemy);
                         break;
                     }
                     case 3: {
-                        UndeadWarrior undeadEnemy;
-                        gameSession.initiateCombat(undeadEnemy);
+                        PooledCreature undeadEnemy = creatureFactory.spawn(CreatureSpecies::UndeadWarrior);
+                        gameSession.initiateCombat(*undeadEnemy);
                         break;
                     }
                     case 4: